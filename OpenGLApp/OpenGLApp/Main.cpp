@@ -1,31 +1,104 @@
 #include "stb_image.h"
 #include "shader_s.h"
 #include "camera.h"
+#include "gl_state.h"
+#include "stream_buffer.h"
+#include "debug_draw.h"
+#include "frustum.h"
+#include "triple_buffer.h"
+#include "spsc_queue.h"
+#include "job_system.h"
+#include "transform_builder.h"
+#include "item_types.h"
+#include "input_recording.h"
+#include "frame_pacer.h"
+#include "menu_cache.h"
+#include "font_atlas.h"
+#include "font_baker.h"
+#include "font_family.h"
+#include "audio_system.h"
+#include "irrklang_backend.h"
+#include "input_events.h"
+#include "logger.h"
+#include "ui.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <random>
 #include <vector>
 #include <string>
 #include <thread>
+#include <atomic>
 #include <chrono>
 #include <json.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 #include <iostream>
 #include <map>
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <cstdlib>
+#include <cstdio>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
-#include <irrKlang.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 using namespace std;
 using json = nlohmann::json;
-using namespace irrklang;
 
-ISoundEngine* soundEngine = createIrrKlangDevice();
+// Sound events of the game are posted to the audio thread, see AudioSystem.
+// Without an audio device (or with --null-audio) the null backend plays them silently
+AudioSystem audio;
+bool nullAudio = false;
+
+// Voice caps of the game's sounds; losing a life outranks any pickup
+struct SoundSetup {
+	const char* name;
+	SoundVoicePolicy policy;
+};
+const SoundSetup soundSetups[] = {
+	//  file                 voices  priority  coalesce s
+	{ "pickup_sound.wav",  { 4,      0,        0.03 } },
+	{ "laser2.wav",        { 2,      2,        0.05 } },
+	{ "laser1.wav",        { 2,      1,        0.05 } },
+	{ "hitting_wall.wav",  { 2,      1,        0.05 } }
+};
+
+// Heap allocations made by the current thread, read by the benchmark suite.
+// Counting costs one thread local increment per allocation, so only the Bench
+// configuration (OPENGLAPP_BENCH_ALLOC) replaces the global allocator
+#ifdef OPENGLAPP_BENCH_ALLOC
+thread_local size_t threadAllocations = 0;
+
+void* operator new(std::size_t size) {
+	threadAllocations++;
+	if (void* p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+// The compiler calls this one when it knows the size, it must free like the one above
+void operator delete(void* p, std::size_t) noexcept {
+	operator delete(p);
+}
+
+inline size_t countedAllocations() {
+	return threadAllocations;
+}
+#else
+inline size_t countedAllocations() {
+	return 0;
+}
+#endif
 
 // Collision handling
 // AABB (Axis-Aligned Bounding Box) structure
@@ -34,14 +107,6 @@ struct AABB {
 	glm::vec3 max;
 };
 
-// Letters
-struct Character {
-	unsigned int TextureID; // ID handle of the glyph texture
-	glm::ivec2 Size; // Size of glyph
-	glm::ivec2 Bearing; // Offset from baseline to left/top of glyph
-	unsigned int Advance; // Horizontal offset to advance to next glyph
-};
-
 // Handle objects
 struct Food {
 	glm::vec3 position;
@@ -58,6 +123,7 @@ struct FlyingObject {
 	bool collided = false;
 };
 std::vector<FlyingObject> flyingObjects;
+const float RocketSize = 0.1f;
 
 // Struct for Vertex
 struct Vertex {
@@ -76,8 +142,52 @@ struct Texture {
 // build and compile shader
 Shader* ourShader = nullptr;
 
-std::map<char, Character> Characters;
-unsigned int txtVAO, txtVBO;
+// Glyphs of the text font, rasterized on first use. Every weight comes from the one
+// variable font file of fontFamily, which owns the atlases
+FontFamily* fontFamily = nullptr;
+FontAtlas* fontAtlas = nullptr;
+const char* const FontCachePath = "font_cache.bin";	// baked atlas, rebuilt when missing or stale
+const float TextWeight = 700.0f;	// bold, on the "wght" axis of Antonio-VariableFont_wght
+unsigned int txtVAO;
+const int TextVertexFloats = 5;	// x, y, u, v, atlas page
+
+// Per-frame geometry (text quads, debug lines) lives in one ring buffer
+StreamBuffer* streamBuffer = nullptr;
+DebugDraw* debugDraw = nullptr;
+
+// Static menu screens are drawn once and then copied, see MenuCache
+MenuCache* mainMenuCache = nullptr;
+MenuCache* pauseMenuCache = nullptr;
+MenuCache* gameOverCache = nullptr;
+MenuCache* guideCache = nullptr;
+int framebufferWidth = 0;
+int framebufferHeight = 0;
+
+// Menu screens as retained widget trees, built once by buildMenus()
+enum MenuAction {
+	ActionStart,
+	ActionQuit,
+	ActionGuide,
+	ActionStress,
+	ActionEasy,
+	ActionMedium,
+	ActionHard,
+	ActionResume,
+	ActionRestart
+};
+struct MenuScreens {
+	UiScreen* main = nullptr;
+	UiScreen* pause = nullptr;
+	UiScreen* gameOver = nullptr;
+	UiScreen* guide = nullptr;
+	int lastRun[3];			// labels: collected, dropped, time played
+	int bestRun[3];
+	int difficulty[3];		// buttons: easy, medium, hard
+	int gameOverCollected;
+	int gameOverDropped;
+};
+MenuScreens menus;
+Shader* uiShader = nullptr;
 
 // settings
 unsigned int SCR_WIDTH = 800;
@@ -129,6 +239,172 @@ int activePowerupId = -1;
 bool powerupActive = false;
 bool showGuide = false;
 bool isVibrating = false;
+bool showFrameStats = false;
+
+// Per-frame counters shown by the F3 overlay
+struct FrameStats {
+	unsigned int drawsVisible = 0;
+	unsigned int drawsCulled = 0;
+};
+FrameStats frameStats;
+FrameStats lastFrameStats;
+
+// Keys and mouse buttons arrive through the GLFW callbacks, each frame acts on the edges since the last one
+InputQueue inputEvents;
+
+// Simulation thread
+// While a game is being played its rules run on their own thread with a fixed step.
+// The main thread samples input into simInputs and draws the newest GameSnapshot;
+// the gameplay globals belong to the simulation thread until stopSimulation() returns.
+const double SimStep = 1.0 / 120.0;
+
+// Input sampled on the main thread, GLFW can only be polled there
+struct SimInput {
+	bool left = false;
+	bool right = false;
+	bool fire = false;		// space: activate or use the collected powerup
+	bool click = false;
+	float mouseX = 0.0f;	// in SCR_WIDTH x SCR_HEIGHT pixels, origin at the bottom left
+	float mouseY = 0.0f;
+};
+
+// Position of an item, rocket or the plate at the last two ticks
+struct BodySnapshot {
+	glm::vec3 previous;
+	glm::vec3 position;
+	int type;
+};
+
+// Copy of everything the renderer needs, published after every tick
+struct GameSnapshot {
+	double time = 0.0;						// when the tick ran, previous positions are one SimStep older
+	double gameTime = 0.0;					// gameTime after the tick
+	std::vector<BodySnapshot> items;		// only items that are still above the plate
+	std::vector<BodySnapshot> rockets;		// only rockets that did not hit a laser
+	BodySnapshot plate;
+	glm::vec3 alienPosition;
+	float clickOffsetX = 0.0f;				// randomX/randomY for the devil click box
+	float clickOffsetY = 0.0f;
+	bool powerupActive = false;
+	int collected = 0;
+	int dropped = 0;
+	int lives = 0;
+	const char* powerupLabel = nullptr;		// nullptr until the first powerup is collected or expires
+};
+
+TripleBuffer<GameSnapshot> gameSnapshots;
+SpscQueue<SimInput, 256> simInputs;
+std::thread simThread;
+std::atomic<bool> simRunning(false);
+const char* powerupLabel = nullptr;
+
+// Positions published with the previous snapshot, owned by the simulation thread
+std::vector<glm::vec3> itemHistory;
+std::vector<glm::vec3> rocketHistory;
+glm::vec3 plateHistory;
+bool snapshotHistoryValid = false;
+
+// Game clock and randomness
+// The rules only read gameTime, which advances by SimStep per tick and stands still
+// while paused, and draw every random number from gameRng, seeded once per game.
+// Given the seed and the input of every tick a game therefore replays exactly.
+double gameTime = 0.0;
+std::mt19937 gameRng;
+unsigned int gameSeed = 0;
+float spawnColumns[3] = { -0.35f, 0.0f, 0.35f };	// shuffled after every third spawn
+int spawnColumnIndex = 0;
+int spawnCount = 0;
+
+// --record <file> logs every game to the file, --replay <file> plays one back
+InputRecording inputRecording;
+std::string recordingPath;
+bool recordingInput = false;
+InputRecording inputReplay;
+bool replayingInput = false;	// simulation thread while a game runs
+bool scoredGame = true;			// false for replays and stress runs, their results stay out of score.json
+
+// Stress mode
+// Spawns items, lasers and rockets at fixed rates instead of following delay and level,
+// nothing costs a life, and after a fixed game time the frame times and entity
+// counts are written as JSON. Started from the menu or with --stress
+struct StressConfig {
+	float itemsPerSecond = 200.0f;
+	float lasersPerSecond = 50.0f;
+	float rocketsPerSecond = 50.0f;
+	double duration = 30.0;				// game seconds
+	std::string outputPath = "stress.json";
+	bool quitWhenDone = false;			// started from the command line
+};
+
+// Spawn state, owned by the simulation thread while the game runs
+struct StressSpawns {
+	double items = 0.0;					// fractional spawns carried to the next tick
+	double lasers = 0.0;
+	double rockets = 0.0;
+	long long spawnedItems = 0;
+	long long spawnedLasers = 0;
+	long long spawnedRockets = 0;
+};
+
+// Measured on the main thread, only for frames that show the stress game
+struct StressStats {
+	std::vector<float> frameMs;
+	double lastFrame = 0.0;				// 0 after a pause, the first frame back is not timed
+	size_t peakItems = 0;
+	size_t peakRockets = 0;
+	double itemSum = 0.0;
+	double rocketSum = 0.0;
+};
+
+// Frame pacing
+// Gameplay frames wait for vsync and optionally for the --fps cap. Menus and an
+// unfocused game only redraw when an event arrives or the timeout runs out, so
+// the timers in the menus still advance
+bool vsyncEnabled = true;
+FramePacer framePacer;
+const double MenuRedrawTimeout = 0.1;
+const double UnfocusedRedrawTimeout = 1.0 / 15.0;
+
+StressConfig stressConfig;
+StressSpawns stressSpawns;
+StressStats stressStats;
+bool stressActive = false;
+
+// Worker threads shared by the simulation and the renderer
+JobSystem* jobSystem = nullptr;
+
+// Items and rockets are split into chunks of this many per job; a handful of
+// items stays on the calling thread without any scheduling cost
+const size_t ItemGrain = 64;
+const size_t RocketGrain = 16;
+
+// Outcome of the parallel item motion pass, the collision responses are applied in order afterwards
+enum ItemMotion : char { ItemInactive, ItemMoved, ItemHitPlate };
+std::vector<char> itemMotion;	// simulation thread
+std::vector<int> rocketHits;	// simulation thread
+
+// Transform and culling radius of every item type, indexed by Food::type
+static_assert(ItemTypeCount <= TransformBuilder::MaxShapes, "too many item types for TransformBuilder");
+InstanceShape itemShapes[ItemTypeCount];
+float itemCullRadii[ItemTypeCount] = {};
+
+// Culling result of one snapshot item
+struct ItemDraw {
+	glm::vec3 position;
+	bool visible;
+	unsigned int matrix;	// index into ItemInstances::models, visible items only
+};
+
+// Per-frame item instances: the positions of the visible items in SoA form and
+// the packed model matrices built from them
+struct ItemInstances {
+	std::vector<float> xs, ys, zs;
+	std::vector<int> types;
+	std::vector<glm::mat4> models;
+	std::vector<ItemDraw> draws;
+	TransformBuilder transforms;
+};
+ItemInstances itemInstances;	// main thread
 
 // lighting
 glm::vec3 lightPos(0.2f, 0.10f, 0.01f);
@@ -194,6 +470,8 @@ glm::vec3 alienPosition = { 0.0f, 1.10f, 0.f };
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow*, int key, int, int action, int);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int);
 void processInput(GLFWwindow* window, int caller);
 void processMenusKeys(GLFWwindow* window, int caller);
 glm::vec3 generateRandomPosition(Food food);
@@ -201,19 +479,45 @@ AABB createAABB(const glm::vec3& position);
 AABB createPlateAABB(const glm::vec3& position);
 bool checkCollision(const AABB& a, const AABB& b);
 void renderText(Shader& s, std::string text, float x, float y, float scale, glm::vec3 color);
+int layoutText(const std::string& text, float x, float y, float scale, float* vertices);
 unsigned int TextureFromFile(const char* path, const std::string& directory);
 int generateRandomObject();
-void renderBoundingBox(float left, float right, float top, float bottom, glm::vec3 color, Shader& shader);
+int generateWeightedObject();
 void startGame();
+void startGame(unsigned int seed);
 int getRandomNumberX();
 int getRandomNumberY();
 void createFlyingObject();
 AABB createRocketAABB(const glm::vec3& position, float size);
-void saveScore(int& collected, int& dropped, float& timePlayed);
-bool loadScores(int& collected, int& dropped, float& timePlayed, int& bestCollected, int& bestDropped, float& bestTimePlayed);
-void renderGuidePage(Shader& shader, GLFWwindow* window);
+void saveScore(int& collected, int& dropped, float& timePlayed, const std::string& path = "score.json");
+bool loadScores(int& collected, int& dropped, float& timePlayed, int& bestCollected, int& bestDropped, float& bestTimePlayed, const std::string& path = "score.json");
+void renderGuidePage();
+void buildMenus(FontAtlas& font);
+void destroyMenus();
+void presentMenu(UiScreen& ui, MenuCache& cache);
+int menuClick(UiScreen& ui);
 void LoadTexture(const char* filename, GLuint& textureID, int textureToCompare);
 bool fileExists(const std::string& filename);
+void processDebugKeys();
+AABB createDevilClickBox(const glm::vec3& position, float offsetX, float offsetY);
+void playSound(const char* name);
+void openAudio(bool silent, bool recordEvents = false);
+void startSimulation();
+void stopSimulation();
+void simulationLoop();
+void simulateGame(const SimInput& input, float currentTime, float dt);
+void stepSimulation(SimInput input);
+void startStressGame();
+void spawnStress(float dt);
+void recordStressFrame(const GameSnapshot& snapshot);
+int finishStressGame();
+bool parseStressArgs(int argc, char** argv, int first);
+bool parseFramePacingArgs(int argc, char** argv);
+void waitForNextFrame(GLFWwindow* window);
+int runHeadlessReplay(const std::string& path);
+void publishSnapshot(double time);
+void sampleSimInput();
+void renderFrameStats(Shader& shader);
 
 // Mesh class
 class Mesh {
@@ -227,33 +531,40 @@ public:
 	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, glm::vec4 diffuseColor = glm::vec4(1.0f))
 		: vertices(vertices), indices(indices), textures(textures), diffuseColor(diffuseColor) {
 		setupMesh();
+		setupMaterial();
 	}
 
+	// The material was resolved at load time, drawing does no string work
 	void Draw(Shader& shader) {
-		unsigned int diffuseNr = 1;
-		unsigned int specularNr = 1;
-		shader.setVec4("diffuseColor", diffuseColor);
-		shader.setBool("useTexture", !textures.empty());
-
-		for (unsigned int i = 0; i < textures.size(); i++) {
-			glActiveTexture(GL_TEXTURE0 + i);
-			std::string number;
-			std::string name = textures[i].type;
-			if (name == "texture_diffuse")
-				number = std::to_string(diffuseNr++);
-			else if (name == "texture_specular")
-				number = std::to_string(specularNr++);
-			shader.setInt(("material." + name + number).c_str(), i);
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
-		}
-		glActiveTexture(GL_TEXTURE0);
-		glBindVertexArray(VAO);
+		material.Apply(shader.ID, *shader.materialUniforms);
+		GLState().BindVertexArray(VAO);
 		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+	}
+
+	// Frees the GL objects. Copies share them, so only call this on the last one
+	void Release() {
+		GLState().DeleteVertexArray(VAO);
+		GLState().DeleteBuffer(VBO);
+		GLState().DeleteBuffer(EBO);
+		for (unsigned int i = 0; i < textures.size(); i++)
+			glDeleteTextures(1, &textures[i].id);
 	}
 
 private:
 	unsigned int VBO, EBO;
+	MaterialBinding material;
+
+	// Diffuse and specular maps take units 0.. in order, other kinds are not sampled
+	void setupMaterial() {
+		material.SetDiffuseColor(diffuseColor);
+		for (unsigned int i = 0; i < textures.size(); i++) {
+			bool specular = textures[i].type == "texture_specular";
+			if ((!specular && textures[i].type != "texture_diffuse") ||
+				!material.AddTexture(textures[i].id, specular ? MaterialBinding::Specular : MaterialBinding::Diffuse)) {
+				std::cerr << "ERROR::MESH:: Texture " << textures[i].path << " left out of the material" << std::endl;
+			}
+		}
+	}
 
 	void setupMesh() {
 		glGenVertexArrays(1, &VAO);
@@ -270,10 +581,11 @@ private:
 
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+		// Same layout as the quads: 0 position, 1 texture coordinates, 2 normal
 		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
 		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
 
 		glBindVertexArray(0);
 	}
@@ -286,10 +598,43 @@ public:
 		loadModel(path);
 	}
 
+	// A model of one mesh built in code, such as the laser quad
+	explicit Model(const Mesh& mesh) : isLoaded(true) {
+		meshes.push_back(mesh);
+		bounds.min = glm::vec3(std::numeric_limits<float>::max());
+		bounds.max = glm::vec3(-std::numeric_limits<float>::max());
+		for (unsigned int i = 0; i < mesh.vertices.size(); i++) {
+			bounds.min = glm::min(bounds.min, mesh.vertices[i].Position);
+			bounds.max = glm::max(bounds.max, mesh.vertices[i].Position);
+		}
+		fitSphere();
+	}
+
 	bool IsLoaded() const {
 		return isLoaded;
 	}
 
+	// Local space bounds, computed once at load time
+	const AABB& Bounds() const {
+		return bounds;
+	}
+
+	const glm::vec3& BoundingCenter() const {
+		return boundingCenter;
+	}
+
+	float BoundingRadius() const {
+		return boundingRadius;
+	}
+
+	// Vertices processed by one Draw()
+	unsigned int IndexCount() const {
+		unsigned int count = 0;
+		for (unsigned int i = 0; i < meshes.size(); i++)
+			count += static_cast<unsigned int>(meshes[i].indices.size());
+		return count;
+	}
+
 	void Draw(Shader& shader) {
 		if (!isLoaded) {
 			std::cerr << "ERROR::MODEL:: Model not loaded, cannot draw." << std::endl;
@@ -300,9 +645,14 @@ public:
 	}
 
 private:
+	friend int runBenchmarkSuite(Model& model, const std::string& modelPath, const std::string& fontPath, const char* outputPath);
+
 	std::vector<Mesh> meshes;
 	std::string directory;
 	bool isLoaded;
+	AABB bounds;
+	glm::vec3 boundingCenter = glm::vec3(0.0f);
+	float boundingRadius = 0.0f;
 
 	void loadModel(const std::string& path) {
 		Assimp::Importer importer;
@@ -316,8 +666,19 @@ private:
 		}
 
 		directory = path.substr(0, path.find_last_of('/'));
+		bounds.min = glm::vec3(std::numeric_limits<float>::max());
+		bounds.max = glm::vec3(-std::numeric_limits<float>::max());
 		processNode(scene->mRootNode, scene);
 		isLoaded = true;
+		fitSphere();
+	}
+
+	// Sphere around the box, good enough for culling
+	void fitSphere() {
+		if (bounds.min.x <= bounds.max.x) {
+			boundingCenter = (bounds.min + bounds.max) * 0.5f;
+			boundingRadius = glm::length(bounds.max - boundingCenter);
+		}
 	}
 
 	void processNode(aiNode* node, const aiScene* scene) {
@@ -343,6 +704,8 @@ private:
 			vector.y = mesh->mVertices[i].y;
 			vector.z = mesh->mVertices[i].z;
 			vertex.Position = vector;
+			bounds.min = glm::min(bounds.min, vector);
+			bounds.max = glm::max(bounds.max, vector);
 
 			vector.x = mesh->mNormals[i].x;
 			vector.y = mesh->mNormals[i].y;
@@ -404,10 +767,79 @@ private:
 	}
 };
 
-Model LoadModelWithFallback(const std::string& primaryPath, const std::string& secondaryPath);
+Model* itemModels[ItemTypeCount] = {};	// loaded from the model files of itemTypes, see loadItemModels()
 
-int main()
+Model LoadModelWithFallback(const std::string& primaryPath, const std::string& secondaryPath);
+void loadItemModels();
+void destroyItemModels();
+bool isCulled(const Frustum& frustum, const glm::vec3& center, float radius);
+bool isCulled(const Frustum& frustum, const Model& model, const glm::vec3& position, float scale);
+void setModelMatrix(Shader& shader, const glm::mat4& model);
+void setModelMatrix(Shader& shader, const glm::mat4& model, const glm::mat3& normalMatrix);
+int runNormalMatrixBenchmark(Model& model);
+int runBenchmarkSuite(Model& model, const std::string& modelPath, const std::string& fontPath, const char* outputPath);
+void countDraw(bool visible);
+void initItemShapes();
+void moveItems(JobSystem& jobs, std::vector<Food>& items, float speed, float dt, const AABB& plateAABB, std::vector<char>& hits);
+void moveRockets(JobSystem& jobs, std::vector<FlyingObject>& rockets, const std::vector<Food>& items, float dt, std::vector<int>& hits);
+void prepareItemDraws(JobSystem& jobs, const std::vector<BodySnapshot>& items, float alpha, float angle, const Frustum& frustum, ItemInstances& instances);
+int runJobSystemBenchmark();
+int runTransformBenchmark();
+
+int main(int argc, char** argv)
 {
+	initItemShapes();
+
+	// CPU only benchmark, no window needed
+	if (argc > 1 && std::string(argv[1]) == "--bench-jobs") {
+		return runJobSystemBenchmark();
+	}
+	if (argc > 1 && std::string(argv[1]) == "--bench-transforms") {
+		return runTransformBenchmark();
+	}
+	if (argc > 2 && std::string(argv[1]) == "--decode-log") {
+		return Logger::Decode(argv[2], std::cout) ? 0 : -1;
+	}
+
+	if (!parseFramePacingArgs(argc, argv)) {
+		return -1;
+	}
+	std::string logPath;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--null-audio") {
+			nullAudio = true;
+		}
+		else if (arg.compare(0, 13, "--log-binary=") == 0) {
+			logPath = arg.substr(13);
+		}
+	}
+	if (!GameLog().Start(logPath)) {
+		std::cout << "Failed to create log " << logPath << std::endl;
+		return -1;
+	}
+
+	// Recording and replaying games
+	if (argc > 2 && std::string(argv[1]) == "--replay-headless") {
+		return runHeadlessReplay(argv[2]);
+	}
+	if (argc > 2 && std::string(argv[1]) == "--record") {
+		recordingPath = argv[2];
+		recordingInput = true;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--stress") {
+		if (!parseStressArgs(argc, argv, 2)) {
+			return -1;
+		}
+		stressConfig.quitWhenDone = true;
+	}
+	if (argc > 2 && std::string(argv[1]) == "--replay") {
+		if (!inputReplay.Load(argv[2], static_cast<int>(DifficultyLevel::Easy), static_cast<int>(DifficultyLevel::Hard))) {
+			std::cout << "Failed to load replay " << argv[2] << std::endl;
+			return -1;
+		}
+	}
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -429,8 +861,11 @@ int main()
 		return -1;
 	}
 	glfwMakeContextCurrent(window);
+	glfwSwapInterval(vsyncEnabled ? 1 : 0);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetScrollCallback(window, scroll_callback);
+	glfwSetKeyCallback(window, key_callback);
+	glfwSetMouseButtonCallback(window, mouse_button_callback);
 
 	// Capture our mouse
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
@@ -447,6 +882,15 @@ int main()
 	// -----------------------------
 	glEnable(GL_DEPTH_TEST);
 
+	// Quads have no normal array, the shader then reads this constant facing the camera
+	glVertexAttrib3f(2, 0.0f, 0.0f, 1.0f);
+
+	// 1 MB per frame in flight is far more than the HUD and menus ever write
+	streamBuffer = new StreamBuffer(1 << 20);
+
+	// The main thread works on its own jobs while waiting, so one core is left to it
+	jobSystem = new JobSystem(std::max(1u, std::thread::hardware_concurrency()) - 1);
+
 	// Create the shader object based on their paths
 	if (fileExists("shaders/shader.vs")) {
 		ourShader = new Shader("shaders/shader.vs", "shaders/shader.frag");
@@ -466,26 +910,12 @@ int main()
 	
 	// Define objects models
 	// -----------------------------
-	Model croissantModel = LoadModelWithFallback(
-		"objects/croissant.obj",
-		"../../OpenGLApp/objects/croissant.obj"
-	);
+	loadItemModels();
+	Model& croissantModel = *itemModels[0];
 	Model plateModel = LoadModelWithFallback(
 		"objects/sgorbio.obj",
 		"../../OpenGLApp/objects/sgorbio.obj"
 	);
-	Model cupModel = LoadModelWithFallback(
-		"objects/togocup.obj",
-		"../../OpenGLApp/objects/togocup.obj"
-	);
-	Model gusModel = LoadModelWithFallback(
-		"objects/gus2.obj",
-		"../../OpenGLApp/objects/gus2.obj"
-	);
-	Model muffinModel = LoadModelWithFallback(
-		"objects/muffin2.obj",
-		"../../OpenGLApp/objects/muffin2.obj"
-	);
 	Model alienModel = LoadModelWithFallback(
 		"objects/ufo.obj",
 		"../../OpenGLApp/objects/ufo.obj"
@@ -494,26 +924,15 @@ int main()
 		"objects/laser.obj",
 		"../../OpenGLApp/OpenGLApp/objects/laser.obj"
 	);
-	Model devilModel = LoadModelWithFallback(
-		"objects/devil.obj",
-		"../../OpenGLApp/OpenGLApp/objects/devil.obj"
-	);
-	Model carrotModel = LoadModelWithFallback(
-		"objects/carrot.obj",
-		"../../OpenGLApp/OpenGLApp/objects/carrot.obj"
-	);
-	Model wineModel = LoadModelWithFallback(
-		"objects/wine.obj",
-		"../../OpenGLApp/OpenGLApp/objects/wine.obj"
-	);
 	Model auraPowerupModel = LoadModelWithFallback(
 		"objects/auraPowerup.obj",
 		"../../OpenGLApp/OpenGLApp/objects/auraPowerup.obj"
 	);
-	Model rocketModel = LoadModelWithFallback(
-		"objects/rocket.obj",
-		"../../OpenGLApp/OpenGLApp/objects/rocket.obj"
-	);
+
+	// Bounding spheres of the item models for the parallel culling pass
+	for (int t = 0; t < ItemTypeCount; t++) {
+		itemCullRadii[t] = itemTypes[t].scale * (glm::length(itemModels[t]->BoundingCenter()) + itemModels[t]->BoundingRadius());
+	}
 
 	// Compile and setup the shader
 	// ----------------------------
@@ -524,97 +943,64 @@ int main()
 	shader.use();
 	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
-	FT_Library ft;
-	if (FT_Init_FreeType(&ft)) {
-		std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-		return -1;
-	}
-	std::string font_name = "../../OpenGLApp/resources/fonts/Antonio/static/Antonio-Bold.ttf";
-	FT_Face face;
-	if (FT_New_Face(ft, font_name.c_str(), 0, &face)) {
-		cout << "Not fouded first\n";
-		std::string font_name = "resources/fonts/Antonio/static/Antonio-Bold.ttf";
-		if (FT_New_Face(ft, font_name.c_str(), 0, &face)) {
-			std::string font_name = "resources/fonts/Antonio/static/Antonio-Bold.ttf";
-			std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-			return -1;
-		}
-		else {
-			cout << "Founded Antonio fonts\n";
-		}
-	}
-
-	if (!soundEngine) {
-		std::cerr << "Could not initialize irrKlang sound engine" << std::endl;
-		return -1;
+	std::string font_name = "../../OpenGLApp/resources/fonts/Antonio/Antonio-VariableFont_wght.ttf";
+	if (!fileExists(font_name)) {
+		font_name = "resources/fonts/Antonio/Antonio-VariableFont_wght.ttf";
 	}
 
-	FT_Set_Pixel_Sizes(face, 0, 48);
+	openAudio(nullAudio);
 
-	if (FT_Load_Char(face, 'X', FT_LOAD_RENDER))
-	{
-		std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-		return -1;
+	// Glyphs are distance fields so every text scale stays sharp. The atlas baked on an
+	// earlier run loads without FreeType; without one, printable ASCII is rasterized
+	// and baked now, other glyphs are rasterized the first time they are drawn
+	fontFamily = new FontFamily();
+	if (fontFamily->Open(font_name)) {
+		fontAtlas = fontFamily->Instance(TextWeight, 48, GlyphRender::DistanceField, FontCachePath);
 	}
-
-	// disable byte-alignment restriction
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-	// Load characters
-	for (unsigned char c = 0; c < 128; c++)
+	if (!fontAtlas)
 	{
-		// load character glyph 
-		if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-		{
-			std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-			continue;
-		}
-		// generate texture
-		unsigned int texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(
-			GL_TEXTURE_2D,
-			0,
-			GL_RED,
-			face->glyph->bitmap.width,
-			face->glyph->bitmap.rows,
-			0,
-			GL_RED,
-			GL_UNSIGNED_BYTE,
-			face->glyph->bitmap.buffer
-		);
-		// set texture options
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		// now store character for later use
-		Character character = {
-			texture,
-			glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-			glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-			face->glyph->advance.x
-		};
-		Characters.insert(std::pair<char, Character>(c, character));
+		std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+		return -1;
 	}
+	shader.setBool("distanceField", fontAtlas->Render() == GlyphRender::DistanceField);
 
-	FT_Done_Face(face);
-	FT_Done_FreeType(ft);
-
-	// configure VAO/VBO for texture quads
+	// configure VAO for texture quads, the vertices are streamed every frame
 	// -----------------------------------
 	glGenVertexArrays(1, &txtVAO);
-	glGenBuffers(1, &txtVBO);
 	glBindVertexArray(txtVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, txtVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, streamBuffer->Buffer());
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, TextVertexFloats * sizeof(float), 0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, TextVertexFloats * sizeof(float), (void*)(4 * sizeof(float)));
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 	//----------- END text handling
 
+	// Line batch for click boxes and the collision overlay
+	if (fileExists("shaders/debug_draw.vs")) {
+		debugDraw = new DebugDraw("shaders/debug_draw.vs", "shaders/debug_draw.frag", *streamBuffer);
+	}
+	else {
+		debugDraw = new DebugDraw("../../OpenGLApp/debug_draw.vs", "../../OpenGLApp/debug_draw.frag", *streamBuffer);
+	}
+
+	mainMenuCache = new MenuCache();
+	pauseMenuCache = new MenuCache();
+	gameOverCache = new MenuCache();
+	guideCache = new MenuCache();
+
+	if (fileExists("shaders/ui.vs")) {
+		uiShader = new Shader("shaders/ui.vs", "shaders/ui.frag");
+	}
+	else {
+		uiShader = new Shader("../../OpenGLApp/ui.vs", "../../OpenGLApp/ui.frag");
+	}
+	uiShader->use();
+	uiShader->setMat4("projection", projection);
+	uiShader->setBool("distanceField", fontAtlas->Render() == GlyphRender::DistanceField);
+	buildMenus(*fontAtlas);
+
 	float conveyorBeltVertices[] = {
 		// first triangle
 		0.60f, 1.20f, -0.01f,    1.0f, 1.0f,  // top right
@@ -715,28 +1101,6 @@ int main()
 	glEnableVertexAttribArray(1);
 
 
-	// LASER
-	// --------------------------------------------------------------------------------------------------
-	unsigned int laserVAO, laserVBO, laserEBO;
-	glGenVertexArrays(1, &laserVAO);
-	glGenBuffers(1, &laserVBO);
-	glGenBuffers(1, &laserEBO);
-
-	glBindVertexArray(laserVAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, laserVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(laserVertices), laserVertices, GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, laserEBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(laserIndices), laserIndices, GL_STATIC_DRAW);
-
-	// Posizioni
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	// Coordinate di texture (opzionale)
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
@@ -804,34 +1168,29 @@ int main()
 
 	// Load and create textures
 	// -------------------------
-	GLuint texture0, texture1, texture2, texture3, texture4, texture5, texture6, texture7, texture8, texture9, texture10;
-
-	LoadTexture("resources/container.jpg", texture0, 0);
-	LoadTexture("resources/carrot.jpg", texture1, 0);
-	LoadTexture("resources/cb4.jpg", texture2, 0);
-	LoadTexture("resources/croissant.jpg", texture3, 0);
-	LoadTexture("resources/cup.jpg", texture4, 0);
-	LoadTexture("resources/gus.jpg", texture5, 0);
-	LoadTexture("resources/muffin.jpg", texture6, 1);
-	LoadTexture("resources/alien.jpg", texture7, 0);
-	LoadTexture("resources/wine.jpg", texture8, 0);
-	LoadTexture("resources/ufo.jpg", texture9, 0);
-	LoadTexture("resources/rocket.jpg", texture10, 0);
+	// Texture unit i holds textureN with N == i, as selected by "textureID" in the shader
+	const unsigned int numObjectTextures = 11;
+	GLuint objectTextures[numObjectTextures];
+
+	LoadTexture("resources/container.jpg", objectTextures[0], 0);
+	LoadTexture("resources/carrot.jpg", objectTextures[1], 0);
+	LoadTexture("resources/cb4.jpg", objectTextures[2], 0);
+	LoadTexture("resources/croissant.jpg", objectTextures[3], 0);
+	LoadTexture("resources/cup.jpg", objectTextures[4], 0);
+	LoadTexture("resources/gus.jpg", objectTextures[5], 0);
+	LoadTexture("resources/muffin.jpg", objectTextures[6], 1);
+	LoadTexture("resources/alien.jpg", objectTextures[7], 0);
+	LoadTexture("resources/wine.jpg", objectTextures[8], 0);
+	LoadTexture("resources/ufo.jpg", objectTextures[9], 0);
+	LoadTexture("resources/rocket.jpg", objectTextures[10], 0);
 
 	// Textures for the objects
+	// Sampler uniforms are program state, so they only need to be set once
 	// -------------------------------------------------------------------------------------------
 	ourShader->use();
-	ourShader->setInt("texture0", 0);
-	ourShader->setInt("texture1", 1);
-	ourShader->setInt("texture2", 2);
-	ourShader->setInt("texture3", 3);
-	ourShader->setInt("texture4", 4);
-	ourShader->setInt("texture5", 5);
-	ourShader->setInt("texture6", 6);
-	ourShader->setInt("texture7", 7);
-	ourShader->setInt("texture8", 8);
-	ourShader->setInt("texture9", 9);
-	ourShader->setInt("texture10", 10);
+	for (unsigned int i = 0; i < numObjectTextures; i++) {
+		ourShader->setInt("texture" + std::to_string(i), i);
+	}
 
 	// Lightning definitions
 	Shader lightingShader("", "");
@@ -901,17 +1260,12 @@ int main()
 
 	// Model transformation matrix
 	glm::mat4 lightModel = glm::mat4(1.0f);
-	lightingShader.setMat4("model", lightModel);
+	setModelMatrix(lightingShader, lightModel);
 	lightingShader.setMat4("view", camera.GetViewMatrix());
 	lightingShader.setMat4("projection", projection);
 	// -----------------------------
 	// END lightning definitions
 
-	float quitLeft = (SCR_WIDTH / 2.0f - 50) + 15;
-	float quitRight = quitLeft + 65;
-	float quitTop = (SCR_HEIGHT / 2.0f - 100 - 30) - 20;
-	float quitBottom = SCR_HEIGHT / 2.0f - 100;
-
 	std::string collisionMessage = "Object collected: " + std::to_string(numberOfCollisions);
 	std::string objectMessage = "Object dropped: " + std::to_string(numberOfObject);
 	std::string livesCounter = "Lives: " + std::to_string(lives);
@@ -919,833 +1273,437 @@ int main()
 
 	// Load scores
 	int lastCollected = 0, lastDropped = 0; float lastTimePlayed = 0.0f; DifficultyLevel usedDifficulty = DifficultyLevel::Easy;
+	bool scoresStale = true;	// score.json is only read again after a game saved to it
 	int bestCollected = 0, bestDropped = 0; float bestTimePlayed = 0.0f; DifficultyLevel bestUsedDifficulty = DifficultyLevel::Easy;
 
+	// Everything above talked to GL directly, start the cache from a clean slate
+	GLState().Invalidate();
+
+	// Vertex throughput benchmark instead of the game
+	if (argc > 1 && std::string(argv[1]) == "--bench-normals") {
+		int result = runNormalMatrixBenchmark(croissantModel);
+		glfwTerminate();
+		return result;
+	}
+
+	// CPU cost of the game's hot functions as JSON, optionally written to a file
+	if (argc > 1 && std::string(argv[1]) == "--bench-suite") {
+		std::string croissantPath = fileExists("objects/croissant.obj") ? "objects/croissant.obj" : "../../OpenGLApp/objects/croissant.obj";
+		int result = runBenchmarkSuite(croissantModel, croissantPath, font_name, argc > 2 ? argv[2] : nullptr);
+		glfwTerminate();
+		return result;
+	}
+
+	// A replay skips the menu and plays the recorded game from its first tick
+	if (inputReplay.TickCount() > 0) {
+		currentDifficulty = static_cast<DifficultyLevel>(inputReplay.Difficulty());
+		startGame(inputReplay.Seed());
+		replayingInput = true;
+		scoredGame = false;
+		currentState = GameState::Game;
+	}
+	if (stressConfig.quitWhenDone) {
+		startStressGame();
+	}
+
 	// render loop
 	// -----------
 	while (!glfwWindowShouldClose(window))
 	{
+		// Nothing to show while minimized: pause a running game and sleep until the window is restored
+		if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) {
+			if (currentState == GameState::Game) {
+				stopSimulation();
+				stressStats.lastFrame = 0.0;
+				currentState = GameState::PauseMenu;
+			}
+			glfwWaitEvents();
+			continue;
+		}
+
+		GLState().BeginFrame();
+		streamBuffer->BeginFrame();
+		fontAtlas->BeginFrame();
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		lastFrameStats = frameStats;
+		frameStats = FrameStats();
+		inputEvents.BeginFrame();
+		processDebugKeys();
+
 		float currentFrame = glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
-		float vibrationTimer = 0.0f;
 
 		const float conveyorSpeed = 0.2f * deltaTime;
 
 		switch (currentState) {
 		case GameState::MainMenu: {
-			// Timer to track when the pause menu was entered
-			static float pauseMenuEnterTime = 0.0f;
-			static bool firstEnter = true;
-			static bool escKeyProcessed = false;
-			if (firstEnter) {
-				pauseMenuEnterTime = static_cast<float>(glfwGetTime());
-				firstEnter = false;
-				escKeyProcessed = false;
-			}
-
 			processInput(window, 0);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
 			if (showGuide) {
 				currentState = GameState::GuideMenu;
 			}
 
-			double xpos, ypos;
-			glfwGetCursorPos(window, &xpos, &ypos);
-
-			// Convert mouse coordinates
-			float mouseX = xpos * (static_cast<float>(SCR_WIDTH) / windowWidth);
-			float mouseY = (windowHeight - ypos) * (static_cast<float>(SCR_HEIGHT) / windowHeight);
-
-			// Define bounding box
-			float easyLeft = SCR_WIDTH / 2.0f - 180;
-			float easyRight = easyLeft + 50;
-			float easyTop = (SCR_HEIGHT / 2.0f) + 30;
-			float easyBottom = (SCR_HEIGHT / 2.0f);
-
-			float mediumLeft = (SCR_WIDTH / 2.0f - 60);
-			float mediumRight = mediumLeft + 80;
-			float mediumTop = (SCR_HEIGHT / 2.0f) + 30;
-			float mediumBottom = (SCR_HEIGHT / 2.0f);
-
-			float hardLeft = (SCR_WIDTH / 2.0f + 80);
-			float hardRight = hardLeft + 60;
-			float hardTop = (SCR_HEIGHT / 2.0f) + 30;
-			float hardBottom = (SCR_HEIGHT / 2.0f);
-
-			float startLeft = (SCR_WIDTH / 2.0f - 60);
-			float startRight = startLeft + 163;
-			float startTop = (SCR_HEIGHT / 2.0f - 60 - 30) + 10;
-			float startBottom = (SCR_HEIGHT / 2.0f - 60) + 15;
-
-			float guideLeft = (SCR_WIDTH / 2.0f - 60) - 320;
-			float guideRight = guideLeft + 165;
-			float guideTop = (SCR_HEIGHT / 2.0f - 60 - 30) - 180;
-			float guideBottom = (SCR_HEIGHT / 2.0f - 60) - 175;
-
-			quitLeft = (SCR_WIDTH / 2.0f - 50) + 15 - 20;
-			quitRight = quitLeft + 62;
-			quitTop = (SCR_HEIGHT / 2.0f - 100 - 30) - 5;
-			quitBottom = SCR_HEIGHT / 2.0f - 100;
-
-			loadScores(lastCollected, lastDropped, lastTimePlayed, bestCollected, bestDropped, bestTimePlayed);
-
-			std::string lastRunCollected = "Ultima run - Raccolti: " + std::to_string(lastCollected);
-			std::string lastRunDropped = "Oggetti caduti: " + std::to_string(lastDropped);
-			std::string lastRunTime = "Tempo giocato: " + std::to_string(static_cast<int>(std::round(lastTimePlayed)));
-
-			std::string bestRunCollected = "Miglior run - Raccolti: " + std::to_string(bestCollected);
-			std::string bestRunDropped = "Oggetti caduti: " + std::to_string(bestDropped);
-			std::string bestRunTime = "Tempo giocato: " + std::to_string(static_cast<int>(std::round(bestTimePlayed)));
-
-
-			// Print on screen
-			float lineSpacing = 30.0f;
-			renderText(shader, lastRunCollected, SCR_WIDTH / 2.0f - 370, SCR_HEIGHT / 2.0f + 250, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
-			renderText(shader, lastRunDropped, SCR_WIDTH / 2.0f - 370, SCR_HEIGHT / 2.0f + 250 - lineSpacing, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
-			renderText(shader, lastRunTime, SCR_WIDTH / 2.0f - 370, SCR_HEIGHT / 2.0f + 250 - 2 * lineSpacing, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
-
-			renderText(shader, bestRunCollected, SCR_WIDTH / 2.0f + 150, SCR_HEIGHT / 2.0f + 370 - 4 * lineSpacing, 0.5f, glm::vec3(1.0f, 1.0f, 0.0f));
-			renderText(shader, bestRunDropped, SCR_WIDTH / 2.0f + 150, SCR_HEIGHT / 2.0f + 370 - 5 * lineSpacing, 0.5f, glm::vec3(1.0f, 1.0f, 0.0f));
-			renderText(shader, bestRunTime, SCR_WIDTH / 2.0f + 150, SCR_HEIGHT / 2.0f + 370 - 6 * lineSpacing, 0.5f, glm::vec3(1.0f, 1.0f, 0.0f));
-
-			renderText(shader, "Welcome!", SCR_WIDTH / 2.0f - 100, SCR_HEIGHT / 2.0f + 130, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-			renderText(shader, "Choose difficulty:", SCR_WIDTH / 2.0f - 130, SCR_HEIGHT / 2.0f + 50, 0.7f, glm::vec3(1.0f, 1.0f, 1.0f));
-
-			float textOffsetY = -20.0f;
-			renderText(shader, "Easy", easyLeft, easyTop + textOffsetY, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
-			renderText(shader, "Medium", mediumLeft, mediumTop + textOffsetY, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
-			renderText(shader, "Hard", hardLeft, hardTop + textOffsetY, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
-
-			renderText(shader, "Start Game", startLeft, startTop, 0.8f, glm::vec3(0.0f, 1.0f, 0.0f));
-			renderText(shader, "Quit", quitLeft, quitTop, 0.8f, glm::vec3(1.0f, 0.0f, 0.0f));
-			renderText(shader, "Guide Page", guideLeft, guideTop, 0.8f, glm::vec3(1.0f, 1.0f, 0.0f));
-
-			//renderBoundingBox(startLeft, startRight, startTop, startBottom, glm::vec3(0.0f, 1.0f, 0.0f), *ourShader);
-			//renderBoundingBox(quitLeft, quitRight, quitTop, quitBottom, glm::vec3(0.0f, 1.0f, 0.0f), *ourShader);
-			//renderBoundingBox(guideLeft, guideRight, guideTop, guideBottom, glm::vec3(0.0f, 1.0f, 0.0f), *ourShader);
-
-			//renderBoundingBox(easyLeft, easyRight, easyTop, easyBottom, glm::vec3(0.0f, 1.0f, 0.0f), *ourShader);
-			//renderBoundingBox(mediumLeft, mediumRight, mediumTop, mediumBottom, glm::vec3(0.0f, 1.0f, 0.0f), *ourShader);
-			//renderBoundingBox(hardLeft, hardRight, hardTop, hardBottom, glm::vec3(0.0f, 1.0f, 0.0f), *ourShader);
-
-			if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-				if (mouseX >= startLeft && mouseX <= startRight && mouseY >= startTop && mouseY <= startBottom) {
-					startGame();
-					//glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-					pastTime = static_cast<float>(glfwGetTime());
-					currentState = GameState::Game;
-				}
-				if (mouseX >= quitLeft && mouseX <= quitRight && mouseY >= quitTop && mouseY <= quitBottom) {
-					glfwSetWindowShouldClose(window, true);
-				}
+			if (scoresStale) {
+				loadScores(lastCollected, lastDropped, lastTimePlayed, bestCollected, bestDropped, bestTimePlayed);
+				scoresStale = false;
+				menus.main->SetText(menus.lastRun[0], "Ultima run - Raccolti: " + std::to_string(lastCollected));
+				menus.main->SetText(menus.lastRun[1], "Oggetti caduti: " + std::to_string(lastDropped));
+				menus.main->SetText(menus.lastRun[2], "Tempo giocato: " + std::to_string(static_cast<int>(std::round(lastTimePlayed))));
+				menus.main->SetText(menus.bestRun[0], "Miglior run - Raccolti: " + std::to_string(bestCollected));
+				menus.main->SetText(menus.bestRun[1], "Oggetti caduti: " + std::to_string(bestDropped));
+				menus.main->SetText(menus.bestRun[2], "Tempo giocato: " + std::to_string(static_cast<int>(std::round(bestTimePlayed))));
+			}
 
-				if (mouseX >= easyLeft && mouseX <= easyRight && mouseY <= easyTop && mouseY >= easyBottom) {
-					std::cout << "current diff " << static_cast<int>(currentDifficulty) << std::endl;
-					currentDifficulty = DifficultyLevel::Easy;
-				}
-				if (mouseX >= mediumLeft && mouseX <= mediumRight && mouseY <= mediumTop && mouseY >= mediumBottom) {
-					std::cout << "current diff " << static_cast<int>(currentDifficulty) << std::endl;
-					currentDifficulty = DifficultyLevel::Medium;
-				}
-				if (mouseX >= hardLeft && mouseX <= hardRight && mouseY <= hardTop && mouseY >= hardBottom) {
-					std::cout << "current diff " << static_cast<int>(currentDifficulty) << std::endl;
-					currentDifficulty = DifficultyLevel::Hard;
-				}
-				if (mouseX >= guideLeft && mouseX <= guideRight && mouseY >= guideTop && mouseY <= guideBottom) {
-					std::cout << "premuto/n";
-					currentState = GameState::GuideMenu;
-				}
+			// The selected difficulty is highlighted
+			for (int i = 0; i < 3; i++) {
+				bool selected = static_cast<int>(currentDifficulty) == i + 1;
+				menus.main->SetColor(menus.difficulty[i], selected ? glm::vec3(1.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 1.0f, 1.0f));
 			}
 
-			// Block ESC input for the first 0.5 seconds to prevent flickering
-			float currentTime = glfwGetTime();
-			ourShader->setFloat("time", currentTime);
-
-			if (currentTime - pauseMenuEnterTime > 0.5f) {
-				if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-					if (!escKeyProcessed) {
-						//glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-						pastTime = static_cast<float>(glfwGetTime());
-						currentState = GameState::MainMenu;
-						firstEnter = true;
-						escKeyProcessed = true;
-					}
-				}
-				else {
-					escKeyProcessed = false;
-				}
+			// Redrawn only for new scores, another difficulty or a new window size
+			presentMenu(*menus.main, *mainMenuCache);
+
+			switch (menuClick(*menus.main)) {
+			case ActionStart:
+				startGame();
+				//glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+				currentState = GameState::Game;
+				break;
+			case ActionQuit:
+				glfwSetWindowShouldClose(window, true);
+				break;
+			case ActionEasy:
+				currentDifficulty = DifficultyLevel::Easy;
+				break;
+			case ActionMedium:
+				currentDifficulty = DifficultyLevel::Medium;
+				break;
+			case ActionHard:
+				currentDifficulty = DifficultyLevel::Hard;
+				break;
+			case ActionGuide:
+				currentState = GameState::GuideMenu;
+				break;
+			case ActionStress:
+				startStressGame();
+				break;
 			}
+
+			ourShader->setFloat("time", static_cast<float>(glfwGetTime()));
 			break;
 		}
 
 		case GameState::Game: {
-			if (lives > 0) {
-				// Timer to track when the pause menu was entered
-				static float pauseMenuEnterTime = 0.0f;
-				static bool firstEnter = true;
-				static bool escKeyProcessed = false;
-
-				float alienLeft = 0;
-				float alienRight = 0;
-				float alienTop = 0;
-				float alienBottom = 0;
-				float width = 30.0f;
-				float height = 30.0f;
-
-				if (firstEnter) {
-					pauseMenuEnterTime = static_cast<float>(glfwGetTime());
-					firstEnter = false;
-					escKeyProcessed = false;
+			// Runs the rules until the game is paused or over, publishing one snapshot per tick
+			startSimulation();
+			sampleSimInput();
+			gameSnapshots.Update();
+			const GameSnapshot& snapshot = gameSnapshots.ReadBuffer();
+
+			if (snapshot.lives <= 0) {
+				stopSimulation();
+				int totalObjDropped = numberOfObject - 2;
+				if (scoredGame) {
+					saveScore(numberOfCollisions, totalObjDropped, pastTime);
+					scoresStale = true;
 				}
+				menus.gameOver->SetText(menus.gameOverCollected, collisionMessage);
+				menus.gameOver->SetText(menus.gameOverDropped, "Total object dropped: " + std::to_string(totalObjDropped));
+				currentState = GameState::GameOverMenu;
+				break;
+			}
 
-				processInput(window, 1);
-
-				// render
-				// ------
-				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-				glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+			if (stressActive) {
+				if (snapshot.gameTime >= stressConfig.duration) {
+					stopSimulation();
+					finishStressGame();
+					if (stressConfig.quitWhenDone)
+						glfwSetWindowShouldClose(window, true);
+					currentState = GameState::MainMenu;
+					break;
+				}
+				recordStressFrame(snapshot);
+			}
 
-				double xpos, ypos;
-				glfwGetCursorPos(window, &xpos, &ypos);
+			// Draw one tick behind the simulation, blending the last two ticks
+			float alpha = static_cast<float>((glfwGetTime() - snapshot.time) / SimStep);
+			alpha = std::min(std::max(alpha, 0.0f), 1.0f);
 
-				// Convert mouse coordinates
-				float mouseX = xpos * (static_cast<float>(SCR_WIDTH) / windowWidth);
-				float mouseY = (windowHeight - ypos) * (static_cast<float>(SCR_HEIGHT) / windowHeight);
+			// HUD strings are only rebuilt when the counter behind them changed
+			static int shownCollected = -1, shownDropped = -1, shownLives = -1;
+			if (snapshot.collected != shownCollected) {
+				shownCollected = snapshot.collected;
+				collisionMessage = "Object collected: " + std::to_string(shownCollected);
+			}
+			if (snapshot.dropped != shownDropped) {
+				shownDropped = snapshot.dropped;
+				objectMessage = "Object dropped: " + std::to_string(shownDropped);
+			}
+			if (snapshot.lives != shownLives) {
+				shownLives = snapshot.lives;
+				livesCounter = "Lives: " + std::to_string(shownLives);
+			}
+			if (snapshot.powerupLabel && powerupMessage != snapshot.powerupLabel) {
+				powerupMessage = snapshot.powerupLabel;
+			}
 
-				// Handle continuous cube appearance
-				float currentTime = static_cast<float>(glfwGetTime());
+			// render
+			// ------
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
-				if (currentTime >= pastDifficulty + increaseDifficulty) {
-					if (level > 1) cubeSpeed += 0.003f / level;
-					delay -= 0.5f / level;
-					pastDifficulty = currentTime;
-					level++;
-				}
+			// RENDER OBJECTS
+			ourShader->use();
+			GLState().SetBlend(false);
 
-				if (currentTime >= pastTime + delay) {
-					// keep adding cubes
-					Food food;
-					food.type = -1; // required inizialization
-					food.type = generateRandomObject();
-					food.position = generateRandomPosition(food);
-					foods.push_back(food);
-
-					std::cout << "Spawned at " << currentTime << " with speed " << cubeSpeed << " with delay " << delay << std::endl;
-					cout << "Game time: " << pastTime << "/n";
-					if (food.type == 5) {
-						randomY = getRandomNumberY();
-						randomX = getRandomNumberX();
-					}
-					if (food.type != 4) numberOfObject++;
-					pastTime = currentTime;
-
-					objectMessage = "Object dropped: " + std::to_string(numberOfObject);
-				}
-				
-				if (powerupActive && activePowerupId == 0) {
-					float currentTime = static_cast<float>(glfwGetTime());
-					float powerupElapsedTime = currentTime - powerupStartTime;
-
-					if (powerupElapsedTime >= powerupDuration) {
-						collectedPowerupId = -1;
-						activePowerupId = -1;
-						powerupActive = false;
-						std::cout << "Power-up scaduto!" << std::endl;
-						powerupMessage = "None";
-					}
-				}
-				else if (powerupActive && activePowerupId == 1) {
-					float currentTime = static_cast<float>(glfwGetTime());
-					float powerupElapsedTime = currentTime - powerupStartTime;
-
-					if (powerupElapsedTime >= powerupDuration) {
-						collectedPowerupId = -1;
-						activePowerupId = -1;
-						powerupActive = false;
-						std::cout << "Power-up scaduto!" << std::endl;
-						powerupMessage = "None";
-					}
-				}
+			// Text rendering borrows unit 0, every other unit is only rebound when something else used it
+			for (unsigned int t = 0; t < numObjectTextures; t++) {
+				GLState().BindTexture(t, objectTextures[t]);
+			}
 
-				// RENDER OBJECTS
-				ourShader->use();
-				for (unsigned int i = 0; i < foods.size(); i++) {
-					foods[i].position.z = 0.2f;
-					if (foods[i].position.y <= -1.10f) {
-						continue;
-					}
-
-					// Update position
-					foods[i].position.y -= cubeSpeed * deltaTime;
-
-					// Create AABB for the current object after position update and plate
-					AABB objectAABB = createAABB(foods[i].position);
-					AABB plateAABB = createPlateAABB(platePosition);
-
-					// Check for collision
-					if (checkCollision(objectAABB, plateAABB)) {
-						if (foods[i].type == 4 || foods[i].type == 5) {
-							if (activePowerupId == 0) {
-								foods[i].position.y = -10.0f;
-
-								livesCounter = "Lives: " + std::to_string(lives);
-							}
-							else {
-								lives--;
-								foods[i].position.y = -10.0f;
-								livesCounter = "Lives: " + std::to_string(lives);
-								if (fileExists("../../OpenGLApp/sounds/laser2.wav")) {
-									soundEngine->play2D("../../OpenGLApp/sounds/laser2.wav", false);
-								}
-								else if (fileExists("sounds/laser2.wav")) {
-									soundEngine->play2D("sounds/laser2.wav", false);
-								}
-								isVibrating = true;
-								vibrationTimer = glfwGetTime();
-							}
-						}
-						else {
-							if (foods[i].type == 6) {
-								collectedPowerupId = 0;
-								powerupMessage = "Carrot!";
-							}
-							else if (foods[i].type == 7) {
-								collectedPowerupId = 1;
-								powerupMessage = "Wine!";
-							}
-							numberOfCollisions++;
-							foods[i].position.y = -10.0f;
-
-							collisionMessage = "Object collected: " + std::to_string(numberOfCollisions);
-							if (fileExists("../../OpenGLApp/sounds/pickup_sound.wav")) {
-								soundEngine->play2D("../../OpenGLApp/sounds/pickup_sound.wav", false);
-							}
-							else if (fileExists("sounds/pickup_sound.wav")) {
-								soundEngine->play2D("sounds/pickup_sound.wav", false);
-							}
-						}
-					}
-
-					// Render cube
-					glm::mat4 objModel = glm::mat4(1.0f);
-					if (foods[i].type == 0) {
-						float angle = glfwGetTime();
-						objModel = glm::translate(objModel, foods[i].position);
-						objModel = glm::scale(objModel, glm::vec3(0.2f, 0.2f, 0.2f));
-						objModel = glm::rotate(objModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			// Set projection and view matrices
+			glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+			ourShader->setMat4("projection", projection);
+			glm::mat4 view = camera.GetViewMatrix();
+			ourShader->setMat4("view", view);
 
-						ourShader->setInt("textureID", 3);
-						ourShader->setMat4("model", objModel);
-						croissantModel.Draw(*ourShader);
-					}
-					else if (foods[i].type == 1) {
-						float angle = glfwGetTime();
-						objModel = glm::translate(objModel, foods[i].position);
-						objModel = glm::scale(objModel, glm::vec3(0.045f, 0.045f, 0.045f));
-						objModel = glm::rotate(objModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			// Every draw below is tested against the camera frustum before its model matrix is built
+			Frustum frustum(projection * view);
+			float angle = static_cast<float>(glfwGetTime());
 
-						ourShader->setInt("textureID", 4);
-						ourShader->setMat4("model", objModel);
-						cupModel.Draw(*ourShader);
-					}
-					else if (foods[i].type == 2) {
-						float angle = glfwGetTime();
-						objModel = glm::translate(objModel, foods[i].position);
-						objModel = glm::scale(objModel, glm::vec3(0.03f, 0.03f, 0.03f));
-						objModel = glm::rotate(objModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			// Interpolation and culling of all items run in parallel, then the matrices of the visible ones
+			prepareItemDraws(*jobSystem, snapshot.items, alpha, angle, frustum, itemInstances);
 
-						ourShader->setInt("textureID", 5);
-						ourShader->setMat4("model", objModel);
-						gusModel.Draw(*ourShader);
-					}
-					else if (foods[i].type == 3) {
-						float angle = glfwGetTime();
-						objModel = glm::translate(objModel, foods[i].position);
-						objModel = glm::scale(objModel, glm::vec3(0.04f, 0.04f, 0.04f));
-						objModel = glm::rotate(objModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			bool laserShading = false;	// isLaser of ourShader, switched only when the item type changes it
+			for (unsigned int i = 0; i < snapshot.items.size(); i++) {
+				const ItemDraw& draw = itemInstances.draws[i];
+				int type = snapshot.items[i].type;
 
-						ourShader->setInt("textureID", 6);
-						ourShader->setMat4("model", objModel);
-						muffinModel.Draw(*ourShader);
-					}
-					else if (foods[i].type == 4) {
-						alienPosition.x = foods[i].position.x;
-						ourShader->setBool("isLaser", true);
-						ourShader->setVec3("laserColor", glm::vec3(1.0f, 0.0f, 0.0f)); // Red
+				if (debugDraw->IsEnabled()) {
+					AABB objectAABB = createAABB(draw.position);
+					debugDraw->Box(objectAABB.min, objectAABB.max, glm::vec3(1.0f, 1.0f, 0.0f));
+					debugDraw->Cross(draw.position, 0.05f, glm::vec3(1.0f, 1.0f, 0.0f));
+				}
 
-						// Render il laser
-						glm::mat4 laserModelStructure = glm::mat4(1.0f);
-						laserModelStructure = glm::translate(laserModelStructure, foods[i].position);
-
-						ourShader->setMat4("model", laserModelStructure);
-						glBindVertexArray(laserVAO);
-						glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-						glBindVertexArray(0);
-
-						ourShader->setBool("isLaser", false);
-					}
-					else if (foods[i].type == 5) {
-						float angle = glfwGetTime();
-						glm::mat4 devilModelStructure = glm::mat4(1.0f);
-						glActiveTexture(GL_TEXTURE0);
-						glBindTexture(GL_TEXTURE_2D, texture0);
-						glBindVertexArray(plateVAO);
-						devilModelStructure = glm::translate(devilModelStructure, foods[i].position);
-						devilModelStructure = glm::scale(devilModelStructure, glm::vec3(0.08f, 0.08f, 0.08f));
-
-						ourShader->setMat4("model", devilModelStructure);
-						ourShader->setInt("textureID", 7);
-						devilModel.Draw(*ourShader);
-						glDrawArrays(GL_TRIANGLES, 0, 6);
-
-						// Update bounding box coordinates based on object position
-						alienLeft = (foods[i].position.x - width) + randomX;
-						alienRight = (foods[i].position.x + width) + randomX;
-						alienTop = (foods[i].position.y + height) + randomY;
-						alienBottom = (foods[i].position.y - height) + randomY;
-						renderBoundingBox(alienLeft, alienRight, alienTop, alienBottom, glm::vec3(1.0f, 0.0f, 0.0f), *ourShader);
-
-						if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-							if (mouseX >= alienLeft && mouseX <= alienRight && mouseY <= alienTop && mouseY >= alienBottom)
-							{
-								cout << "Preso!" << "/n";
-								numberOfCollisions++;
-								foods[i].position.y = -10.0f;
-								collisionMessage = "Object collected: " + std::to_string(numberOfCollisions);
-
-								if (fileExists("../../OpenGLApp/sounds/pickup_sound.wav")) {
-									soundEngine->play2D("../../OpenGLApp/sounds/pickup_sound.wav", false);
-								}
-								else if (fileExists("sounds/pickup_sound.wav")) {
-									soundEngine->play2D("sounds/pickup_sound.wav", false);
-								}
-							}
-						}
-					}
-					else if (foods[i].type == 6) {
-						float angle = glfwGetTime();
-						objModel = glm::translate(objModel, foods[i].position);
-						objModel = glm::scale(objModel, glm::vec3(0.1f, 0.1f, 0.1f));
-						objModel = glm::rotate(objModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+				if (itemTypes[type].clickable) {
+					// The click box is part of the game, so it is drawn even with the overlay off
+					AABB clickBox = createDevilClickBox(draw.position, snapshot.clickOffsetX, snapshot.clickOffsetY);
+					debugDraw->ScreenRect(clickBox.min.x, clickBox.max.x, clickBox.max.y, clickBox.min.y, glm::vec3(1.0f, 0.0f, 0.0f));
+				}
 
-						ourShader->setInt("textureID", 1);
-						ourShader->setMat4("model", objModel);
-						carrotModel.Draw(*ourShader);
-					}
-					else if (foods[i].type == 7) {
-						float angle = glfwGetTime();
-						objModel = glm::translate(objModel, foods[i].position);
-						objModel = glm::scale(objModel, glm::vec3(0.04f, 0.04f, 0.04f));
-						objModel = glm::rotate(objModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+				countDraw(draw.visible);
+				if (!draw.visible) {
+					continue;
+				}
+				setModelMatrix(*ourShader, itemInstances.models[draw.matrix], itemInstances.transforms.NormalMatrix(type));
 
-						ourShader->setInt("textureID", 8);
-						ourShader->setMat4("model", objModel);
-						wineModel.Draw(*ourShader);
-					}
+				if (itemTypes[type].laser != laserShading) {
+					laserShading = itemTypes[type].laser;
+					ourShader->setBool("isLaser", laserShading);
+					if (laserShading)
+						ourShader->setVec3("laserColor", glm::vec3(1.0f, 0.0f, 0.0f)); // Red
 				}
+				ourShader->setInt("textureID", itemTypes[type].texture);
+				itemModels[type]->Draw(*ourShader);
+			}
+			if (laserShading) {
+				ourShader->setBool("isLaser", false);
+			}
 
-				for (unsigned int i = 0; i < flyingObjects.size(); i++) {
-					// Update rocket position
-					flyingObjects[i].position.y += flyingObjects[i].speedY * deltaTime;
-					flyingObjects[i].position.z = 0.2f;
+			for (unsigned int i = 0; i < snapshot.rockets.size(); i++) {
+				glm::vec3 position = glm::mix(snapshot.rockets[i].previous, snapshot.rockets[i].position, alpha);
 
-					// Create rocket AABB
-					AABB rocketAABB = createRocketAABB(flyingObjects[i].position, flyingObjects[i].size);
+				if (debugDraw->IsEnabled()) {
+					AABB rocketAABB = createRocketAABB(position, RocketSize);
+					debugDraw->Box(rocketAABB.min, rocketAABB.max, glm::vec3(0.0f, 1.0f, 1.0f));
+				}
 
-					for (unsigned int j = 0; j < foods.size(); j++) {
-						if (foods[j].type == 4) { // Se è il laser
+				// Render rocket, rockets that left the top of the screen are culled
+				const ItemType& rocket = itemTypes[snapshot.rockets[i].type];
+				if (!isCulled(frustum, position, itemCullRadii[snapshot.rockets[i].type])) {
+					glm::mat4 objModel = glm::mat4(1.0f);
+					objModel = glm::translate(objModel, position);
+					objModel = glm::scale(objModel, glm::vec3(rocket.scale));
+					if (rocket.spins)
+						objModel = glm::rotate(objModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
 
-							// Crea laser AABB
-							AABB laserAABB = createAABB(foods[j].position);
+					ourShader->setInt("textureID", rocket.texture);
+					setModelMatrix(*ourShader, objModel);
+					itemModels[snapshot.rockets[i].type]->Draw(*ourShader);
+				}
+			}
 
-							if (checkCollision(rocketAABB, laserAABB) && !flyingObjects[i].collided) {
-								std::cout << "Collisione tra razzo e laser!" << std::endl;
+			// Render conveyor belt
+			ourShader->use();
+			glm::mat4 model = glm::mat4(1.0f);
+			for (int i = 0; i < 2; i++) {
+				conveyorBeltPositions[i].y -= conveyorSpeed;
+				if (conveyorBeltPositions[i].y <= -2.4f) {
+					// Reset position when off-screen
+					conveyorBeltPositions[i].y = 2.4f;
+				}
 
-								foods[j].type = -1; // Deactivate il laser
-								flyingObjects[i].collided = true;
-								flyingObjects[i].position = glm::vec3{ -10, -10, -10 };
-								break;
-							}
-						}
-					}
+				// Render the conveyor belt
+				glm::mat4 conveyorModel = glm::mat4(1.0f);
+				conveyorModel = glm::translate(conveyorModel, conveyorBeltPositions[i]);
+				setModelMatrix(*ourShader, conveyorModel);
+				ourShader->setInt("textureID", 2);
+				GLState().BindVertexArray(conveyorVAO);
+				glDrawArrays(GL_TRIANGLES, 0, 6);
+			}
 
-					// Render rocket
-					if (!flyingObjects[i].collided) {
-						glm::mat4 objModel = glm::mat4(1.0f);
-						float angle = glfwGetTime();
+			// light properties
+			glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
 
-						objModel = glm::translate(objModel, flyingObjects[i].position);
-						objModel = glm::scale(objModel, glm::vec3(0.045f, 0.045f, 0.045f));
-						objModel = glm::rotate(objModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			glm::vec3 diffuseColor = lightColor * glm::vec3(1.0f);
+			glm::vec3 ambientColor = diffuseColor * glm::vec3(1.0f);
 
-						ourShader->setInt("textureID", 10);
-						ourShader->setMat4("model", objModel);
-						rocketModel.Draw(*ourShader);
-					}
-				}
+			ourShader->setVec3("light.color", lightColor);
+			ourShader->setVec3("light.ambient", ambientColor);
+			ourShader->setVec3("light.diffuse", diffuseColor);
+			ourShader->setVec3("light.specular", glm::vec3(1.0f, 1.0f, 1.0f));
 
-				ourShader->use();
-				// Bind textures
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, texture0);
-				ourShader->setInt("texture0", 0);
-
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, texture1);
-				ourShader->setInt("texture1", 1);
-
-				glActiveTexture(GL_TEXTURE2);
-				glBindTexture(GL_TEXTURE_2D, texture2);
-				ourShader->setInt("texture2", 2);
-
-				glActiveTexture(GL_TEXTURE3);
-				glBindTexture(GL_TEXTURE_2D, texture3);
-				ourShader->setInt("texture3", 3);
-
-				glActiveTexture(GL_TEXTURE4);
-				glBindTexture(GL_TEXTURE_2D, texture4);
-				ourShader->setInt("texture4", 4);
-				
-				glActiveTexture(GL_TEXTURE5);
-				glBindTexture(GL_TEXTURE_2D, texture5);
-				ourShader->setInt("texture5", 5);
-
-				glActiveTexture(GL_TEXTURE6);
-				glBindTexture(GL_TEXTURE_2D, texture6);
-				ourShader->setInt("texture6", 6);
-
-				glActiveTexture(GL_TEXTURE7);
-				glBindTexture(GL_TEXTURE_2D, texture7);
-				ourShader->setInt("texture7", 7);
-
-				glActiveTexture(GL_TEXTURE8);
-				glBindTexture(GL_TEXTURE_2D, texture8);
-				ourShader->setInt("texture8", 8);
-
-				glActiveTexture(GL_TEXTURE9);
-				glBindTexture(GL_TEXTURE_2D, texture9);
-				ourShader->setInt("texture9", 9);
-
-				glActiveTexture(GL_TEXTURE10);
-				glBindTexture(GL_TEXTURE_2D, texture10);
-				ourShader->setInt("texture10", 10);
-
-
-				// Set projection and view matrices
-				glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-				ourShader->setMat4("projection", projection);
-				glm::mat4 view = camera.GetViewMatrix();
-				ourShader->setMat4("view", view);
-
-				// Render conveyor belt
-				ourShader->use();
-				glBindVertexArray(conveyorVAO);
-				glm::mat4 model = glm::mat4(1.0f);
-				for (int i = 0; i < 2; i++) {
-					conveyorBeltPositions[i].y -= conveyorSpeed;
-					if (conveyorBeltPositions[i].y <= -2.4f) {
-						// Reset position when off-screen
-						conveyorBeltPositions[i].y = 2.4f;
-					}
-
-					// Render the conveyor belt
-					glm::mat4 conveyorModel = glm::mat4(1.0f);
-					conveyorModel = glm::translate(conveyorModel, conveyorBeltPositions[i]);
-					ourShader->setMat4("model", conveyorModel);
-					ourShader->setInt("textureID", 2);
-					glBindVertexArray(conveyorVAO);
-					glDrawArrays(GL_TRIANGLES, 0, 6);
-				}
+			// material properties
+			ourShader->setVec3("material.ambient", 1.0f, 1.0f, 1.0f);
+			ourShader->setVec3("material.diffuse", 1.0f, 1.0f, 1.0f);
+			ourShader->setVec3("material.specular", 0.0f, 0.0f, 0.0f);
+			ourShader->setFloat("material.shininess", 2.0f);
 
-				// light properties
-				glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
-
-				glm::vec3 diffuseColor = lightColor * glm::vec3(1.0f);
-				glm::vec3 ambientColor = diffuseColor * glm::vec3(1.0f);
-
-				ourShader->setVec3("light.color", lightColor);
-				ourShader->setVec3("light.ambient", ambientColor);
-				ourShader->setVec3("light.diffuse", diffuseColor);
-				ourShader->setVec3("light.specular", glm::vec3(1.0f, 1.0f, 1.0f));
-
-				// material properties
-				ourShader->setVec3("material.ambient", 1.0f, 1.0f, 1.0f);
-				ourShader->setVec3("material.diffuse", 1.0f, 1.0f, 1.0f);
-				ourShader->setVec3("material.specular", 0.0f, 0.0f, 0.0f);
-				ourShader->setFloat("material.shininess", 2.0f);
-
-				// Render plate
-				if (isVibrating) {
-					float elapsedTime = glfwGetTime() - vibrationTimer;
-					float offsetVib = sin(elapsedTime * 50.0f) * vibrationIntensity;
-
-					if (elapsedTime < vibrationDuration) {
-						platePosition.x += offsetVib;
-					}
-					else {
-						platePosition.x += offsetVib / 2;
-						isVibrating = false;
-					}
-				}
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, texture0);
-				glBindVertexArray(plateVAO);
-				model = glm::translate(glm::mat4(1.0f), platePosition);
+			// Render plate
+			glm::vec3 platePos = glm::mix(snapshot.plate.previous, snapshot.plate.position, alpha);
+			if (!isCulled(frustum, plateModel, platePos, 0.1f)) {
+				model = glm::translate(glm::mat4(1.0f), platePos);
 				model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-				ourShader->setMat4("model", model);
+				setModelMatrix(*ourShader, model);
 				ourShader->setInt("textureID", 0);
 				plateModel.Draw(*ourShader);
+			}
 
-				if (powerupActive == true) {
-					glm::mat4 objModel = glm::mat4(1.0f);
-					float angle = 80.0f;
+			if (debugDraw->IsEnabled()) {
+				AABB plateAABB = createPlateAABB(platePos);
+				debugDraw->Box(plateAABB.min, plateAABB.max, glm::vec3(0.0f, 1.0f, 0.0f));
+			}
 
-					objModel = glm::translate(objModel, platePosition);
-					objModel = glm::scale(objModel, glm::vec3(0.13f, 0.13f, 0.13f));
-					objModel = glm::rotate(objModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			if (snapshot.powerupActive && !isCulled(frustum, auraPowerupModel, platePos, 0.13f)) {
+				glm::mat4 objModel = glm::mat4(1.0f);
 
-					ourShader->setInt("textureID", -1);
-					ourShader->setMat4("model", objModel);
-					auraPowerupModel.Draw(*ourShader);
-				}
-				glDrawArrays(GL_TRIANGLES, 0, 6);
+				objModel = glm::translate(objModel, platePos);
+				objModel = glm::scale(objModel, glm::vec3(0.13f, 0.13f, 0.13f));
+				objModel = glm::rotate(objModel, 80.0f, glm::vec3(0.0f, 1.0f, 0.0f));
 
-				// Render alien
-				float angle = glfwGetTime();
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, texture0);
-				glBindVertexArray(plateVAO);
-				modelAlienStructure = glm::translate(glm::mat4(1.0f), alienPosition);
+				ourShader->setInt("textureID", -1);
+				setModelMatrix(*ourShader, objModel);
+				auraPowerupModel.Draw(*ourShader);
+			}
+
+			// Render alien
+			if (!isCulled(frustum, alienModel, snapshot.alienPosition, 0.15f)) {
+				modelAlienStructure = glm::translate(glm::mat4(1.0f), snapshot.alienPosition);
 				modelAlienStructure = glm::scale(modelAlienStructure, glm::vec3(0.15f, 0.15f, 0.15f));
 				modelAlienStructure = glm::rotate(modelAlienStructure, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-				ourShader->setMat4("model", modelAlienStructure);
+				setModelMatrix(*ourShader, modelAlienStructure);
 				ourShader->setInt("textureID", 9);
 				alienModel.Draw(*ourShader);
-				glDrawArrays(GL_TRIANGLES, 0, 6);
-
-				// Render text
-				glUseProgram(shader.ID); 
-				renderText(shader, objectMessage, 10.0f, 550.0f, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
-				renderText(shader, collisionMessage, 10.0f, 480.0f, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
-				renderText(shader, livesCounter, 10.0f, 410.0f, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
-				renderText(shader, powerupMessage, 10.0f, 340.0f, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
-
-				// Restore OpenGL state for 3D rendering
-				glBindVertexArray(0);
-				glBindTexture(GL_TEXTURE_2D, 0);
-				glDisable(GL_BLEND);
-
-				// Block ESC input for the first 0.5 seconds to prevent flickering
-				float currentEscTime = static_cast<float>(glfwGetTime());
-				if (currentEscTime - pauseMenuEnterTime > 0.5f) {
-					if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-						if (!escKeyProcessed) {
-							pastTime = static_cast<float>(glfwGetTime());
-							currentState = GameState::PauseMenu;
-							firstEnter = true;
-							escKeyProcessed = true;
-						}
-					}
-					else {
-						escKeyProcessed = false;
-					}
-				}
+			}
 
+			// Render text
+			shader.use();
+			renderText(shader, objectMessage, 10.0f, 550.0f, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
+			renderText(shader, collisionMessage, 10.0f, 480.0f, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
+			renderText(shader, livesCounter, 10.0f, 410.0f, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
+			renderText(shader, powerupMessage, 10.0f, 340.0f, 0.6f, glm::vec3(1.0f, 1.0f, 1.0f));
+
+			// Only a new press pauses, the one that resumed the game is not seen again
+			if (inputEvents.Pressed(GLFW_KEY_ESCAPE)) {
+				stopSimulation();
+				stressStats.lastFrame = 0.0;
+				currentState = GameState::PauseMenu;
 			}
-			else currentState = GameState::GameOverMenu;
 			break;
 		}
 
 		case GameState::GameOverMenu: {
 			processInput(window, 2);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			double xpos, ypos;
-			glfwGetCursorPos(window, &xpos, &ypos);
-
-			// Convert mouse coordinates
-			float mouseX = xpos * (static_cast<float>(SCR_WIDTH) / windowWidth);
-			float mouseY = (windowHeight - ypos) * (static_cast<float>(SCR_HEIGHT) / windowHeight);
-
-			// Define bounding box
-			float restartLeft = SCR_WIDTH / 2.0f - 60;
-			float restartRight = restartLeft + 110;
-			float restartTop = SCR_HEIGHT / 2.0f - 60 - 30;
-			float restartBottom = SCR_HEIGHT / 2.0f - 60;
-
-			// Render "Game Over" screen
-			int totalObjDropped = numberOfObject - 2;
-			std::string correctObjDropped = "Total object dropped: " + std::to_string(totalObjDropped);
-			renderText(shader, "Game Over", SCR_WIDTH / 2.0f - 100, SCR_HEIGHT / 2.0f + 100, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-			renderText(shader, correctObjDropped, (SCR_WIDTH / 2.0f - 150) + 10, SCR_HEIGHT / 2.0f - 10, 0.8f, glm::vec3(1.0f, 1.0f, 1.0f));
-			renderText(shader, collisionMessage, (SCR_WIDTH / 2.0f - 150) + 10, SCR_HEIGHT / 2.0f + 40, 0.8f, glm::vec3(1.0f, 1.0f, 1.0f));
-			renderText(shader, "Restart", restartLeft, restartTop, 0.8f, glm::vec3(0.0f, 1.0f, 0.0f));
-			renderText(shader, "Quit", quitLeft, quitTop, 0.8f, glm::vec3(1.0f, 0.0f, 0.0f));
-			
-			saveScore(numberOfCollisions, totalObjDropped, pastTime);
-
-			// Handle mouse input for "Restart" and "Quit"
-			if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-				if (mouseX >= restartLeft && mouseX <= restartRight && mouseY >= restartTop && mouseY <= restartBottom) {
-					startGame();
-					pastTime = static_cast<float>(glfwGetTime());
-					currentState = GameState::Game;
-				}
 
-				if (mouseX >= quitLeft && mouseX <= quitRight && mouseY >= quitTop && mouseY <= quitBottom) {
-					glfwSetWindowShouldClose(window, true);
-				}
+			// The counters were set at game over and do not change until the next game
+			presentMenu(*menus.gameOver, *gameOverCache);
+
+			switch (menuClick(*menus.gameOver)) {
+			case ActionRestart:
+				startGame();
+				currentState = GameState::Game;
+				break;
+			case ActionQuit:
+				glfwSetWindowShouldClose(window, true);
+				break;
 			}
 			break;
 		}
 
 		case GameState::PauseMenu: {
-			// Timer to track when the pause menu was entered
-			static float pauseMenuEnterTime = 0.0f;
-			static bool firstEnter = true;
-			static bool escKeyProcessed = false;
-			if (firstEnter) {
-				pauseMenuEnterTime = static_cast<float>(glfwGetTime());
-				firstEnter = false;
-				escKeyProcessed = false;
-			}
-
-			// Clear buffer from previous elements
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			double xpos, ypos;
-			glfwGetCursorPos(window, &xpos, &ypos);
-
-			// Convert mouse coordinates
-			float mouseX = xpos * (static_cast<float>(SCR_WIDTH) / windowWidth);
-			float mouseY = (windowHeight - ypos) * (static_cast<float>(SCR_HEIGHT) / windowHeight);
-
-			// Define the bounding boxes with consistent spacing
-			float buttonWidth = 200.0f;
-			float buttonHeight = 35.0f;
-			float buttonSpacing = 20.0f;
-
-			// Calculate the top-left corner of the first button (Resume)
-			float startX = SCR_WIDTH / 2.0f - buttonWidth / 2.0f;
-			float startY = SCR_HEIGHT / 2.0f - (buttonHeight * 1.5f + buttonSpacing * 2.0f);
-
-			// Quit Game button
-			float quitLeft = startX;
-			float quitRight = quitLeft + buttonWidth - 140;
-			float quitTop = startY;
-			float quitBottom = quitTop + buttonHeight;
-
-			// Restart Game button
-			float restartLeft = startX;
-			float restartRight = restartLeft + buttonWidth;
-			float restartTop = quitBottom + buttonSpacing;
-			float restartBottom = restartTop + buttonHeight;
-
-			// Resume button
-			float resumeLeft = startX;
-			float resumeRight = resumeLeft + buttonWidth + 10;
-			float resumeTop = restartBottom + buttonSpacing;
-			float resumeBottom = resumeTop + buttonHeight;
-
-			// Render text and bounding boxes
-			renderText(shader, "Pause", SCR_WIDTH / 2.0f - 100, SCR_HEIGHT / 2.0f + 100, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-			renderText(shader, "Resume Game", resumeLeft, resumeTop, 0.8f, glm::vec3(0.0f, 1.0f, 0.0f));
-			renderText(shader, "Restart Game", restartLeft, restartTop, 0.8f, glm::vec3(0.0f, 1.0f, 0.0f));
-			renderText(shader, "Quit", quitLeft, quitTop, 0.8f, glm::vec3(1.0f, 0.0f, 0.0f));
-
-			//renderBoundingBox(resumeLeft, resumeRight, resumeTop, resumeBottom, glm::vec3(0.0f, 1.0f, 0.0f), *ourShader); // Green
-			//renderBoundingBox(restartLeft, restartRight, restartTop, restartBottom, glm::vec3(0.0f, 1.0f, 0.0f), *ourShader); // Green
-			//renderBoundingBox(quitLeft, quitRight, quitTop, quitBottom, glm::vec3(1.0f, 0.0f, 0.0f), *ourShader); // Red
-
-			if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-				// Check if the mouse is inside the "Resume Game" bounding box
-				if (mouseX >= resumeLeft && mouseX <= resumeRight && mouseY >= resumeTop && mouseY <= resumeBottom) {
-					pastTime = static_cast<float>(glfwGetTime());
-					currentState = GameState::Game;
-					firstEnter = true;
-				}
-
-				// Check if the mouse is inside the "Restart Game" bounding box
-				if (mouseX >= restartLeft && mouseX <= restartRight && mouseY >= restartTop && mouseY <= restartBottom) {
-					startGame();
-					pastTime = static_cast<float>(glfwGetTime());
-					currentState = GameState::Game;
-					firstEnter = true;
-				}
-
-				// Check if the mouse is inside the "Quit" bounding box
-				if (mouseX >= quitLeft && mouseX <= quitRight && mouseY >= quitTop && mouseY <= quitBottom) {
-					int totObjCorrect = numberOfObject - 2;
+			// The text never changes
+			presentMenu(*menus.pause, *pauseMenuCache);
+
+			switch (menuClick(*menus.pause)) {
+			case ActionResume:
+				currentState = GameState::Game;
+				break;
+			case ActionRestart:
+				startGame();
+				currentState = GameState::Game;
+				break;
+			case ActionQuit: {
+				int totObjCorrect = numberOfObject - 2;
+				if (scoredGame) {
 					saveScore(numberOfCollisions, totObjCorrect, pastTime);
-
-					glfwSetWindowShouldClose(window, true);
+					scoresStale = true;
 				}
-			}
 
-			// Block ESC input for the first 0.5 seconds to prevent flickering
-			float currentTime = static_cast<float>(glfwGetTime());
-			if (currentTime - pauseMenuEnterTime > 0.5f) {
-				if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-					if (!escKeyProcessed) {
-						pastTime = static_cast<float>(glfwGetTime());
-						currentState = GameState::Game;
-						firstEnter = true;
-						escKeyProcessed = true;
-					}
-				}
-				else {
-					escKeyProcessed = false;
-				}
+				glfwSetWindowShouldClose(window, true);
+				break;
+			}
 			}
 
+			if (inputEvents.Pressed(GLFW_KEY_ESCAPE)) {
+				currentState = GameState::Game;
+			}
 			break;
 		}
 
 		case GameState::GuideMenu: {
-			// Timer to track when the pause menu was entered
-			static float pauseMenuEnterTime = 0.0f;
-			static bool firstEnter = true;
-			static bool escKeyProcessed = false;
-			if (firstEnter) {
-				pauseMenuEnterTime = static_cast<float>(glfwGetTime());
-				firstEnter = false;
-				escKeyProcessed = false;
-			}
-
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 			processInput(window, 4);
-			renderGuidePage(shader, window);
-
-			// Block ESC input for the first 0.5 seconds to prevent flickering
-			float currentTime = static_cast<float>(glfwGetTime());
-			if (currentTime - pauseMenuEnterTime > 0.5f) {
-				if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-					if (!escKeyProcessed) {
-						pastTime = static_cast<float>(glfwGetTime());
-						currentState = GameState::MainMenu;
-						firstEnter = true;
-						escKeyProcessed = true;
-					}
-				}
-				else {
-					escKeyProcessed = false;
-				}
-			}
+			renderGuidePage();
 			break;
 		}
 		}
 
-		// Swap buffers and poll events
+		// World lines use the same camera as the game, screen lines the text projection
+		glm::mat4 debugProjection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+		debugDraw->Flush(debugProjection * camera.GetViewMatrix(), projection);
+
+		if (showFrameStats) {
+			renderFrameStats(shader);
+		}
+
+		streamBuffer->EndFrame();
+
+		// Swap buffers and poll events
 		glfwSwapBuffers(window);
-		glfwPollEvents();
+		inputEvents.Presented(glfwGetTime());
+		waitForNextFrame(window);
 	}
 
+	stopSimulation();
+	GameLog().Flush();
+
 	std::cout << "Oggetti: " << numberOfObject << std::endl;
 	std::cout << "Collisioni: " << numberOfCollisions << std::endl;
+	InputQueue::Counters inputStats = inputEvents.Stats();
+	if (inputStats.handled) {
+		std::cout << "Input: " << inputStats.handled << " events, " << inputStats.meanLatency * 1000.0 << " ms mean / "
+			<< inputStats.maxLatency * 1000.0 << " ms max to present" << std::endl;
+	}
 
 
 	// De-allocate all resources once they've outlived their purpose:
@@ -1759,13 +1717,30 @@ int main()
 	glDeleteVertexArrays(1, &VAO);
 	glDeleteBuffers(1, &VBO);
 
-	soundEngine->drop();
+	glDeleteVertexArrays(1, &txtVAO);
+	delete debugDraw;
+	delete mainMenuCache;
+	delete pauseMenuCache;
+	delete gameOverCache;
+	delete guideCache;
+	destroyMenus();
+	delete uiShader;
+	// Keeps glyphs first drawn in this run for the next start
+	fontFamily->SaveBaked();
+	delete fontFamily;
+	fontAtlas = nullptr;
+	delete streamBuffer;
+	delete jobSystem;
+
+	audio.Close();
+	GameLog().Stop();
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 
 	// Clean up
 	delete ourShader;
+	destroyItemModels();
 	glfwTerminate();
 	return 0;
 }
@@ -1808,94 +1783,59 @@ unsigned int TextureFromFile(const char* path, const std::string& directory) {
 	return textureID;
 }
 
-// Declare the random number generator
-std::random_device rd;
-std::mt19937 gen(rd());
 glm::vec3 generateRandomPosition(Food food) {
-	// Fixed x positions
-	static float xPositions[3] = { -0.35f, 0.0f, 0.35f };
-	static int currentIndex = 0;
-
-	// Shuffle the array if we've used all positions
-	if (currentIndex == 0) {
-		std::shuffle(std::begin(xPositions), std::end(xPositions), gen);
+	// Shuffle the fixed x positions if we've used all of them
+	if (spawnColumnIndex == 0) {
+		std::shuffle(std::begin(spawnColumns), std::end(spawnColumns), gameRng);
 	}
 
 	// Get the current x-coordinate and move to the next index
-	float randomX = xPositions[currentIndex];
-	currentIndex = (currentIndex + 1) % 3;
+	float randomX = spawnColumns[spawnColumnIndex];
+	spawnColumnIndex = (spawnColumnIndex + 1) % 3;
 
 	// offset position for more random position
-	static std::random_device rd_offset;
-	static std::mt19937 gen(rd_offset());
-	static std::uniform_real_distribution<double> dist(-0.15, 0.15);
-	float offset = dist(gen);
-
-	if (food.type == 4) {
-		return glm::vec3(randomX + offset, 0.88f, 0.2f);
-	}
+	std::uniform_real_distribution<double> dist(-0.15, 0.15);
+	float offset = dist(gameRng);
 
-	return glm::vec3(randomX + offset, 1.20f, 0.2f);
+	return glm::vec3(randomX + offset, itemTypes[food.type].spawnHeight, 0.2f);
 }
 
 int generateRandomObject() {
-	static int count = 0;
-	static std::mt19937 rng(std::random_device{}());
-	static std::uniform_int_distribution<int> dist(0, 6);
-
-	count++;
-	// Every 3 numbers generate a laser
-	if (count % 3 == 0) {
-		return 4;
+	spawnCount++;
+	// Types with a fixed rhythm (every third spawn is a laser) come first
+	for (int t = 0; t < ItemTypeCount; t++) {
+		if (itemTypes[t].spawnEvery > 0 && spawnCount % itemTypes[t].spawnEvery == 0) {
+			return t;
+		}
 	}
-	else {
-		int num = dist(rng);
-		if (num >= 4) num++;
-		return num;
+
+	return generateWeightedObject();
+}
+
+// Type picked by spawnWeight alone
+int generateWeightedObject() {
+	std::uniform_int_distribution<int> dist(0, totalSpawnWeight() - 1);
+	int pick = dist(gameRng);
+	for (int t = 0; t < ItemTypeCount; t++) {
+		pick -= itemTypes[t].spawnWeight;
+		if (pick < 0) {
+			return t;
+		}
 	}
+	return 0;
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// process all input: react to the keys pressed since the last frame
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow* window, int caller)
 {
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+	if (inputEvents.Pressed(GLFW_KEY_ESCAPE)) {
 		processMenusKeys(window, caller);
 	}
 
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
-		if (platePosition.x <= 0.45f)
-			platePosition.x += 1.0f * deltaTime;
-		else {
-			platePosition.x = 0.45f;
-		}
-	}
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
-		if (platePosition.x >= -0.45f)
-			platePosition.x -= 1.0f * deltaTime;
-		else {
-			platePosition.x = -0.45f;
-		}
-	}
-	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-		if (collectedPowerupId == 0 && !powerupActive) {    // Invincibility
-			activePowerupId = 0;
-			powerupStartTime = static_cast<float>(glfwGetTime());
-			powerupActive = true;
-			std::cout << "Power-up" << collectedPowerupId << "attivato!" << std::endl;
-		}
-		else if (collectedPowerupId == 1 && !powerupActive) {	// Rocket launcher
-			activePowerupId = 1;
-			powerupStartTime = static_cast<float>(glfwGetTime());
-			powerupActive = true;
-			std::cout << "Power-up" << collectedPowerupId << "attivato!" << std::endl;
-		}
-		else if (collectedPowerupId == 1 && powerupActive) {
-			createFlyingObject();
-		}
-	}
+	// The plate and the powerups only react to input while the simulation runs, see sampleSimInput
 
-	if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS) {
+	if (inputEvents.Pressed(GLFW_KEY_H)) {
 		showGuide = true;
 	}
 }
@@ -1960,6 +1900,26 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 	camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
+// glfw: whenever a key goes down or up, this callback queues it for the next frame.
+// Key repeats are not edges and are left out
+// ----------------------------------------------------------------------
+void key_callback(GLFWwindow*, int key, int, int action, int)
+{
+	if (action == GLFW_REPEAT || key == GLFW_KEY_UNKNOWN) {
+		return;
+	}
+	inputEvents.Push(InputEvent::Key, key, action == GLFW_PRESS, 0.0, 0.0, glfwGetTime());
+}
+
+// glfw: whenever a mouse button goes down or up, this callback queues it with the cursor position
+// ----------------------------------------------------------------------
+void mouse_button_callback(GLFWwindow* window, int button, int action, int)
+{
+	double xpos, ypos;
+	glfwGetCursorPos(window, &xpos, &ypos);
+	inputEvents.Push(InputEvent::Mouse, button, action == GLFW_PRESS, xpos, ypos, glfwGetTime());
+}
+
 // Function to create an AABB from position
 AABB createAABB(const glm::vec3& position) {
 	float halfWidth = 0.075f;
@@ -2002,94 +1962,91 @@ void renderText(Shader& s, std::string text, float x, float y, float scale, glm:
 	glUniform3f(glGetUniformLocation(s.ID, "textColor"), color.x, color.y, color.z);
 
 	// Enable blending to handle glyph transparency
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState().SetBlend(true);
+	GLState().BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(txtVAO);
+	GLState().BindVertexArray(txtVAO);
+
+	// Build the quads of the whole string with a single upload, room for one glyph per byte
+	const GLsizeiptr vertexStride = sizeof(float) * TextVertexFloats;
+	StreamBuffer::Allocation quads = streamBuffer->Allocate(text.size() * 6 * vertexStride, vertexStride);
+	if (!quads.ptr) {
+		return;
+	}
+	GLint first = static_cast<GLint>(quads.offset / vertexStride);
+	int count = layoutText(text, x, y, scale, static_cast<float*>(quads.ptr));
+	streamBuffer->Commit();
+
+	// All pages are layers of one texture, so the string is a single draw. Empty glyphs such as spaces are zero area quads
+	GLState().BindTexture(0, fontAtlas->Texture(), GL_TEXTURE_2D_ARRAY);
+	glDrawArrays(GL_TRIANGLES, first, count);
+}
 
-	// iterate through all characters
-	std::string::const_iterator c;
-	for (c = text.begin(); c != text.end(); c++)
+// Writes six vertices (x, y, u, v, page) per visible glyph of the UTF-8 text into vertices,
+// which has room for six per byte. Returns the number of vertices written
+int layoutText(const std::string& text, float x, float y, float scale, float* vertices) {
+	int count = 0;
+	// iterate through all code points
+	for (size_t i = 0; i < text.size();)
 	{
-		Character ch = Characters[*c];
+		const Character& ch = fontAtlas->Glyph(NextCodepoint(text, i));
+		if (ch.Page < 0) {
+			// Blank, or no room for it in the atlas
+			x += (ch.Advance >> 6) * scale;
+			continue;
+		}
 
 		float xpos = x + ch.Bearing.x * scale;
 		float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
 
 		float w = ch.Size.x * scale;
 		float h = ch.Size.y * scale;
-		// update VBO for each character
-		float vertices[6][4] = {
-			{ xpos,     ypos + h,   0.0f, 0.0f },
-			{ xpos,     ypos,       0.0f, 1.0f },
-			{ xpos + w, ypos,       1.0f, 1.0f },
-
-			{ xpos,     ypos + h,   0.0f, 0.0f },
-			{ xpos + w, ypos,       1.0f, 1.0f },
-			{ xpos + w, ypos + h,   1.0f, 0.0f }
+		const glm::vec4& uv = ch.UV;
+		float page = static_cast<float>(ch.Page);
+		float quad[6][TextVertexFloats] = {
+			{ xpos,     ypos + h,   uv.x, uv.y, page },
+			{ xpos,     ypos,       uv.x, uv.w, page },
+			{ xpos + w, ypos,       uv.z, uv.w, page },
+
+			{ xpos,     ypos + h,   uv.x, uv.y, page },
+			{ xpos + w, ypos,       uv.z, uv.w, page },
+			{ xpos + w, ypos + h,   uv.z, uv.y, page }
 		};
-		// render glyph texture over quad
-		glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-		// update content of VBO memory
-		glBindBuffer(GL_ARRAY_BUFFER, txtVBO);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		// render quad
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		memcpy(vertices, quad, sizeof(quad));
+		vertices += 6 * TextVertexFloats;
+		count += 6;
 		x += (ch.Advance >> 6) * scale;
 	}
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	return count;
 }
 
-void renderBoundingBox(float left, float right, float top, float bottom, glm::vec3 color, Shader& shader) {
-	shader.use();
-	shader.setVec3("color", color);
-
-	// Matrici identità per disegno diretto
-	glm::mat4 model = glm::mat4(1.0f);
-	glm::mat4 view = glm::mat4(1.0f);
-	glm::mat4 projection = glm::ortho(0.0f, (float)SCR_WIDTH, 0.0f, (float)SCR_HEIGHT);
-
-	shader.setMat4("model", model);
-	shader.setMat4("view", view);
-	shader.setMat4("projection", projection);
-
-	// Vertici del bounding box
-	float vertices[] = {
-		left, top, 0.0f,
-		right, top, 0.0f,
-		right, bottom, 0.0f,
-		left, bottom, 0.0f
-	};
-
-	unsigned int VAO, VBO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glBindVertexArray(VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glDrawArrays(GL_LINE_LOOP, 0, 4);
-
-	glBindVertexArray(0);
-
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
+// Game reset/begin with a fresh seed
+void startGame() {
+	startGame(std::random_device{}());
 }
 
-// Game reset/begin
-void startGame() {
+// Game reset/begin; the same seed and the same tick inputs play the same game
+void startGame(unsigned int seed) {
+	gameSeed = seed;
+	gameRng.seed(seed);
+	gameTime = 0.0;
+	spawnColumns[0] = -0.35f;
+	spawnColumns[1] = 0.0f;
+	spawnColumns[2] = 0.35f;
+	spawnColumnIndex = 0;
+	spawnCount = 0;
+	replayingInput = false;
+	stressActive = false;
+	scoredGame = true;
+	if (recordingInput) {
+		inputRecording.Begin(seed, static_cast<int>(currentDifficulty));
+	}
+
 	numberOfCollisions = 0;
 	lives = 3;
 	numberOfObject = 1;
 
-	std::cout << "current diff " << static_cast<int>(currentDifficulty) << std::endl;
+	LOG_DEBUG("current diff {}", static_cast<int>(currentDifficulty));
 	if (currentDifficulty == DifficultyLevel::Easy) {
 	}
 	else if (currentDifficulty == DifficultyLevel::Medium) {
@@ -2113,9 +2070,13 @@ void startGame() {
 	activePowerupId = -1;
 	powerupStartTime = 0.0f;
 	powerupActive = false;
+	powerupLabel = nullptr;
+	isVibrating = false;
+	alienPosition = { 0.0f, 1.10f, 0.f };
 
 
 	foods.clear();
+	flyingObjects.clear();
 	Food food;
 	food.type = generateRandomObject();
 	food.position = generateRandomPosition(food);
@@ -2127,33 +2088,29 @@ void startGame() {
 }
 
 int getRandomNumberX() {
-	static std::random_device rd;
-	static std::mt19937 gen(rd());
 	std::uniform_int_distribution<int> dist(570, 770);
-	return dist(gen);
+	return dist(gameRng);
 }
 
 int getRandomNumberY() {
-	static std::random_device rd;
-	static std::mt19937 gen(rd());
 	std::uniform_int_distribution<int> dist(30, 570);
-	return dist(gen);
+	return dist(gameRng);
 }
 
 void createFlyingObject() {
 	FlyingObject obj;
 	obj.position = platePosition;
 	obj.speedY = cubeSpeed;
-	obj.size = 0.1f;
-	obj.type = 8;
+	obj.size = RocketSize;
+	obj.type = rocketItemType();
 	flyingObjects.push_back(obj);
 }
 
-void saveScore(int& collected, int& dropped, float& timePlayed) {
+void saveScore(int& collected, int& dropped, float& timePlayed, const std::string& path) {
 	json j;
 
 	// Load the JSON
-	std::ifstream file("score.json");
+	std::ifstream file(path);
 	if (file.is_open()) {
 		file >> j;
 		file.close();
@@ -2170,13 +2127,13 @@ void saveScore(int& collected, int& dropped, float& timePlayed) {
 		j["best_run"]["time_played"] = timePlayed;
 	}
 
-	std::ofstream outFile("score.json");
+	std::ofstream outFile(path);
 	outFile << j.dump(4);
 	outFile.close();
 }
 
-bool loadScores(int& collected, int& dropped, float& timePlayed, int& bestCollected, int& bestDropped, float& bestTimePlayed) {
-	std::ifstream file("score.json");
+bool loadScores(int& collected, int& dropped, float& timePlayed, int& bestCollected, int& bestDropped, float& bestTimePlayed, const std::string& path) {
+	std::ifstream file(path);
 	if (!file.is_open()) {
 		return false;
 	}
@@ -2196,57 +2153,136 @@ bool loadScores(int& collected, int& dropped, float& timePlayed, int& bestCollec
 	return true;
 }
 
-void renderGuidePage(Shader& shader, GLFWwindow* window) {
-	double xpos, ypos;
-	glfwGetCursorPos(window, &xpos, &ypos);
-
-	// Convert mouse coordinates
-	float mouseX = xpos * (static_cast<float>(SCR_WIDTH) / windowWidth);
-	float mouseY = (windowHeight - ypos) * (static_cast<float>(SCR_HEIGHT) / windowHeight);
-
-	float startX = SCR_WIDTH / 2.0f - 300;
-	float startY = SCR_HEIGHT / 2.0f + 250;
-	float lineSpacing = 30.0f;
+void renderGuidePage() {
+	// The page is static, it is only drawn again for a new window size
+	presentMenu(*menus.guide, *guideCache);
 
-	float quitLeft = (SCR_WIDTH / 2.0f - 60) - 0;
-	float quitRight = quitLeft + 60;
-	float quitTop = (SCR_HEIGHT / 2.0f - 60 - 30) + 10 - 190;
-	float quitBottom = (SCR_HEIGHT / 2.0f - 60) + 15 - 190;
-
-	glm::vec3 titleColor = glm::vec3(1.0f, 1.0f, 0.0f);
-	glm::vec3 textColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	if (menuClick(*menus.guide) == ActionQuit) {
+		showGuide = false;
+		currentState = GameState::MainMenu;
+	}
 
-	renderText(shader, "GUIDA", startX, startY, 0.7f, titleColor);
+	return;
+}
 
-	startY -= lineSpacing * 2;
-	renderText(shader, "Powerup:", startX, startY, 0.6f, titleColor);
-	renderText(shader, "- Carota: invincibile per 10 secondi", startX + 20, startY - lineSpacing, 0.5f, textColor);
-	renderText(shader, "- Vino: spara razzi che distruggono i laser per 10 secondi", startX + 20, startY - 2 * lineSpacing, 0.5f, textColor);
+// Title and indented lines of one guide section, the title baseline at y
+void addGuideSection(UiScreen& ui, const std::string& title, float x, float y, const std::vector<std::string>& lines) {
+	const float lineSpacing = 30.0f;
+	int section = ui.AddPanel(glm::vec2(x, y), glm::vec2(0.0f), glm::vec4(0.0f));
+	ui.AddLabel(title, glm::vec2(0.0f), 0.6f, glm::vec3(1.0f, 1.0f, 0.0f), section);
+	for (size_t i = 0; i < lines.size(); i++) {
+		ui.AddLabel(lines[i], glm::vec2(20.0f, -lineSpacing * (i + 1)), 0.5f, glm::vec3(1.0f, 1.0f, 1.0f), section);
+	}
+}
 
-	startY -= 4 * lineSpacing;
-	renderText(shader, "Comandi:", startX, startY, 0.6f, titleColor);
-	renderText(shader, "- A/Freccia sx: spostarsi a sinistra", startX + 20, startY - lineSpacing, 0.5f, textColor);
-	renderText(shader, "- D/Freccia dx: spostarsi a destra", startX + 20, startY - 2 * lineSpacing, 0.5f, textColor);
-	renderText(shader, "- SPACEBAR: attivazione powerup raccolti", startX + 20, startY - 3 * lineSpacing, 0.5f, textColor);
-	renderText(shader, "- Tasto sx mouse: catturare il demone", startX + 20, startY - 4 * lineSpacing, 0.5f, textColor);
+// Creates the widgets of every menu screen. Texts that depend on the scores are set later with SetText
+void buildMenus(FontAtlas& font) {
+	const float width = static_cast<float>(SCR_WIDTH);
+	const float height = static_cast<float>(SCR_HEIGHT);
+	const float lineSpacing = 30.0f;
+	const glm::vec3 white(1.0f, 1.0f, 1.0f);
+	const glm::vec3 yellow(1.0f, 1.0f, 0.0f);
+	const glm::vec3 green(0.0f, 1.0f, 0.0f);
+	const glm::vec3 red(1.0f, 0.0f, 0.0f);
+
+	// Main menu
+	UiScreen* ui = menus.main = new UiScreen(font, width, height);
+	int lastRun = ui->AddPanel(glm::vec2(width / 2.0f - 370, height / 2.0f + 250 - 2 * lineSpacing), glm::vec2(0.0f), glm::vec4(0.0f));
+	int bestRun = ui->AddPanel(glm::vec2(width / 2.0f + 150, height / 2.0f + 370 - 6 * lineSpacing), glm::vec2(0.0f), glm::vec4(0.0f));
+	for (int i = 0; i < 3; i++) {
+		menus.lastRun[i] = ui->AddLabel("", glm::vec2(0.0f, (2 - i) * lineSpacing), 0.5f, white, lastRun);
+		menus.bestRun[i] = ui->AddLabel("", glm::vec2(0.0f, (2 - i) * lineSpacing), 0.5f, yellow, bestRun);
+	}
+	ui->AddLabel("Welcome!", glm::vec2(width / 2.0f - 100, height / 2.0f + 130), 1.0f, white);
+	ui->AddLabel("Choose difficulty:", glm::vec2(width / 2.0f - 130, height / 2.0f + 50), 0.7f, white);
+	int difficulty = ui->AddPanel(glm::vec2(width / 2.0f - 180, height / 2.0f + 10), glm::vec2(0.0f), glm::vec4(0.0f));
+	menus.difficulty[0] = ui->AddButton("Easy", glm::vec2(0.0f, 0.0f), 0.6f, white, ActionEasy, difficulty);
+	menus.difficulty[1] = ui->AddButton("Medium", glm::vec2(120.0f, 0.0f), 0.6f, white, ActionMedium, difficulty);
+	menus.difficulty[2] = ui->AddButton("Hard", glm::vec2(260.0f, 0.0f), 0.6f, white, ActionHard, difficulty);
+	ui->AddButton("Start Game", glm::vec2(width / 2.0f - 60, height / 2.0f - 80), 0.8f, green, ActionStart);
+	ui->AddButton("Quit", glm::vec2(width / 2.0f - 55, height / 2.0f - 135), 0.8f, red, ActionQuit);
+	ui->AddButton("Guide Page", glm::vec2(width / 2.0f - 380, height / 2.0f - 270), 0.8f, yellow, ActionGuide);
+	ui->AddButton("Stress Test", glm::vec2(width - 200, height / 2.0f - 270), 0.8f, glm::vec3(1.0f, 0.5f, 0.0f), ActionStress);
+
+	// Pause menu, the buttons stacked from the bottom
+	ui = menus.pause = new UiScreen(font, width, height);
+	ui->AddLabel("Pause", glm::vec2(width / 2.0f - 100, height / 2.0f + 100), 1.0f, white);
+	int buttons = ui->AddPanel(glm::vec2(width / 2.0f - 100, height / 2.0f - 92.5f), glm::vec2(200.0f, 145.0f), glm::vec4(0.0f));
+	ui->AddButton("Quit", glm::vec2(0.0f, 0.0f), 0.8f, red, ActionQuit, buttons);
+	ui->AddButton("Restart Game", glm::vec2(0.0f, 55.0f), 0.8f, green, ActionRestart, buttons);
+	ui->AddButton("Resume Game", glm::vec2(0.0f, 110.0f), 0.8f, green, ActionResume, buttons);
+
+	// Game over
+	ui = menus.gameOver = new UiScreen(font, width, height);
+	ui->AddLabel("Game Over", glm::vec2(width / 2.0f - 100, height / 2.0f + 100), 1.0f, red);
+	menus.gameOverCollected = ui->AddLabel("", glm::vec2(width / 2.0f - 140, height / 2.0f + 40), 0.8f, white);
+	menus.gameOverDropped = ui->AddLabel("", glm::vec2(width / 2.0f - 140, height / 2.0f - 10), 0.8f, white);
+	ui->AddButton("Restart", glm::vec2(width / 2.0f - 60, height / 2.0f - 90), 0.8f, green, ActionRestart);
+	ui->AddButton("Quit", glm::vec2(width / 2.0f - 55, height / 2.0f - 135), 0.8f, red, ActionQuit);
+
+	// Guide page
+	ui = menus.guide = new UiScreen(font, width, height);
+	float startX = width / 2.0f - 300;
+	float startY = height / 2.0f + 250;
+	ui->AddLabel("GUIDA", glm::vec2(startX, startY), 0.7f, yellow);
+	addGuideSection(*ui, "Powerup:", startX, startY - 2 * lineSpacing, {
+		"- Carota: invincibile per 10 secondi",
+		"- Vino: spara razzi che distruggono i laser per 10 secondi" });
+	addGuideSection(*ui, "Comandi:", startX, startY - 6 * lineSpacing, {
+		"- A/Freccia sx: spostarsi a sinistra",
+		"- D/Freccia dx: spostarsi a destra",
+		"- SPACEBAR: attivazione powerup raccolti",
+		"- Tasto sx mouse: catturare il demone" });
+	addGuideSection(*ui, "Oggetti:", startX, startY - 12 * lineSpacing, {
+		"- Laser: sparato dall’alieno. Toglie una vita se colpito",
+		"- Demone: toglie una vita se colpito. Evitabile cliccando il box",
+		"- Carota/Vino: danno poteri speciali",
+		"- Altri oggetti: collezionabili" });
+	ui->AddButton("Quit", glm::vec2(width / 2.0f - 60, height / 2.0f - 270), 0.8f, red, ActionQuit);
+}
 
-	startY -= 6 * lineSpacing;
-	renderText(shader, "Oggetti:", startX, startY, 0.6f, titleColor);
-	renderText(shader, "- Laser: sparato dall’alieno. Toglie una vita se colpito", startX + 20, startY - lineSpacing, 0.5f, textColor);
-	renderText(shader, "- Demone: toglie una vita se colpito. Evitabile cliccando il box", startX + 20, startY - 2 * lineSpacing, 0.5f, textColor);
-	renderText(shader, "- Carota/Vino: danno poteri speciali", startX + 20, startY - 3 * lineSpacing, 0.5f, textColor);
-	renderText(shader, "- Altri oggetti: collezionabili", startX + 20, startY - 4 * lineSpacing, 0.5f, textColor);
+void destroyMenus() {
+	delete menus.main;
+	delete menus.pause;
+	delete menus.gameOver;
+	delete menus.guide;
+	menus = MenuScreens();
+}
 
-	renderText(shader, "Quit", quitLeft, quitTop, 0.8f, glm::vec3(1.0f, 0.0f, 0.0f));
+// Draws a menu screen through its offscreen copy, which is refreshed after the widgets changed
+void presentMenu(UiScreen& ui, MenuCache& cache) {
+	if (ui.IsDirty()) {
+		cache.Invalidate();
+	}
+	if (cache.BeginRedraw(framebufferWidth, framebufferHeight)) {
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		ui.Draw(*uiShader);
+		cache.EndRedraw();
+	}
+	cache.Present();
 
-	if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-		if (mouseX >= quitLeft && mouseX <= quitRight && mouseY >= quitTop && mouseY <= quitBottom) {
-			showGuide = false;
-			currentState = GameState::MainMenu;
+	if (debugDraw->IsEnabled()) {
+		for (size_t i = 0; i < ui.WidgetCount(); i++) {
+			const UiWidget& widget = ui.Widget(static_cast<int>(i));
+			if (widget.kind == UiKind::Button) {
+				debugDraw->ScreenRect(widget.min.x, widget.max.x, widget.min.y, widget.max.y, glm::vec3(0.0f, 1.0f, 0.0f));
+			}
 		}
 	}
+}
 
-	return;
+// Action of the button under the cursor when the left mouse button went down this frame, -1 otherwise
+int menuClick(UiScreen& ui) {
+	double xpos, ypos;
+	if (!inputEvents.Clicked(GLFW_MOUSE_BUTTON_LEFT, xpos, ypos)) {
+		return -1;
+	}
+
+	// Convert mouse coordinates
+	float mouseX = xpos * (static_cast<float>(SCR_WIDTH) / windowWidth);
+	float mouseY = (windowHeight - ypos) * (static_cast<float>(SCR_HEIGHT) / windowHeight);
+	return ui.HitTest(mouseX, mouseY);
 }
 
 void LoadTexture(const char* filename, GLuint& textureID, int textureToCompare) {
@@ -2284,6 +2320,35 @@ void LoadTexture(const char* filename, GLuint& textureID, int textureToCompare)
 	stbi_image_free(data);
 }
 
+// One model per item type from the file in its itemTypes entry, the laser quad for the laser
+void loadItemModels() {
+	for (int t = 0; t < ItemTypeCount; t++) {
+		if (itemTypes[t].model) {
+			std::string file = itemTypes[t].model;
+			itemModels[t] = new Model(LoadModelWithFallback("objects/" + file, "../../OpenGLApp/objects/" + file));
+			continue;
+		}
+		std::vector<Vertex> vertices;
+		for (unsigned int v = 0; v < 4; v++) {
+			const float* source = &laserVertices[v * 5];
+			Vertex vertex;
+			vertex.Position = glm::vec3(source[0], source[1], source[2]);
+			vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+			vertex.TexCoords = glm::vec2(source[3], source[4]);
+			vertices.push_back(vertex);
+		}
+		std::vector<unsigned int> indices(laserIndices, laserIndices + 6);
+		itemModels[t] = new Model(Mesh(vertices, indices, std::vector<Texture>()));
+	}
+}
+
+void destroyItemModels() {
+	for (int t = 0; t < ItemTypeCount; t++) {
+		delete itemModels[t];
+		itemModels[t] = nullptr;
+	}
+}
+
 Model LoadModelWithFallback(const std::string& primaryPath, const std::string& secondaryPath) {
 	Model model(primaryPath);
 	if (model.IsLoaded()) {
@@ -2308,3 +2373,1276 @@ bool fileExists(const std::string& filename) {
 	std::ifstream file(filename);
 	return file.good();
 }
+
+// Frustum test for a bounding sphere in world space, counted in the frame stats
+bool isCulled(const Frustum& frustum, const glm::vec3& center, float radius) {
+	bool visible = frustum.IntersectsSphere(center, radius);
+	countDraw(visible);
+	return !visible;
+}
+
+// Models are placed with translate * scale * rotate(Y), so a sphere centered on the
+// position that also contains the rotated local center covers every orientation
+bool isCulled(const Frustum& frustum, const Model& model, const glm::vec3& position, float scale) {
+	float radius = scale * (glm::length(model.BoundingCenter()) + model.BoundingRadius());
+	return isCulled(frustum, position, radius);
+}
+
+// Debug toggles that work in every state
+// ------------------------------------------
+void processDebugKeys() {
+	if (inputEvents.Pressed(GLFW_KEY_F2)) {
+		debugDraw->Toggle();
+	}
+	if (inputEvents.Pressed(GLFW_KEY_F3)) {
+		showFrameStats = !showFrameStats;
+	}
+}
+
+// Overlay with the counters of the previous frame
+void renderFrameStats(Shader& shader) {
+	const GLStateCache::Counters& gl = GLState().LastFrame();
+	std::string glCalls = "GL state calls: " + std::to_string(gl.issued) + " issued / " + std::to_string(gl.skipped) + " skipped";
+
+	const StreamBuffer::Counters& stream = streamBuffer->LastFrame();
+	std::string streamUsage = "Stream buffer: " + std::to_string(stream.bytes / 1024) + " KB in " + std::to_string(stream.allocations)
+		+ " uploads, " + std::to_string(stream.stalls) + " stalls, " + std::to_string(stream.orphans) + " orphans";
+
+	renderText(shader, glCalls, SCR_WIDTH - 330.0f, SCR_HEIGHT - 25.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
+	renderText(shader, streamUsage, SCR_WIDTH - 330.0f, SCR_HEIGHT - 45.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
+	renderText(shader, "Debug lines: " + std::to_string(debugDraw->LastVertexCount() / 2), SCR_WIDTH - 330.0f, SCR_HEIGHT - 65.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
+	renderText(shader, "Draws: " + std::to_string(lastFrameStats.drawsVisible) + " visible / " + std::to_string(lastFrameStats.drawsCulled) + " culled",
+		SCR_WIDTH - 330.0f, SCR_HEIGHT - 85.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
+	AudioSystem::Counters sound = audio.Stats();
+	renderText(shader, "Voices: " + std::to_string(audio.ActiveVoices()) + " playing, " + std::to_string(sound.pool.played) + " played / "
+		+ std::to_string(sound.pool.coalesced) + " coalesced / " + std::to_string(sound.pool.dropped) + " dropped / " + std::to_string(sound.pool.stolen) + " stolen",
+		SCR_WIDTH - 330.0f, SCR_HEIGHT - 105.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
+	renderText(shader, std::string("Audio (") + audio.BackendName() + "): " + std::to_string(static_cast<int>(sound.meanLatency * 1e6)) + " us mean / "
+		+ std::to_string(static_cast<int>(sound.maxLatency * 1e6)) + " us max latency, " + std::to_string(sound.queueFull) + " lost",
+		SCR_WIDTH - 330.0f, SCR_HEIGHT - 125.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
+	InputQueue::Counters input = inputEvents.Stats();
+	renderText(shader, "Input: " + std::to_string(input.handled) + " of " + std::to_string(input.events) + " events handled, "
+		+ std::to_string(static_cast<int>(input.meanLatency * 1e6)) + " us mean / " + std::to_string(static_cast<int>(input.maxLatency * 1e6)) + " us max to present",
+		SCR_WIDTH - 330.0f, SCR_HEIGHT - 145.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
+}
+
+// Uploads the model matrix together with its normal matrix, so no shader has to
+// run inverse() for every vertex
+void setModelMatrix(Shader& shader, const glm::mat4& model) {
+	setModelMatrix(shader, model, glm::inverseTranspose(glm::mat3(model)));
+}
+
+void setModelMatrix(Shader& shader, const glm::mat4& model, const glm::mat3& normalMatrix) {
+	shader.setMat4("model", model);
+	shader.setMat3("normalMatrix", normalMatrix);
+}
+
+// Draws the model many times per frame with the normal matrix computed per vertex
+// in the shader (the old path) and once per draw on the CPU, and prints the GPU time of both
+int runNormalMatrixBenchmark(Model& model) {
+	const int instances = 500;
+	const int warmupFrames = 10;
+	const int frames = 100;
+
+	bool installed = fileExists("shaders/shader_light.vs");
+	Shader perVertex(installed ? "shaders/bench_light_inverse.vs" : "../../OpenGLApp/bench_light_inverse.vs",
+		installed ? "shaders/shader_light.frag" : "../../OpenGLApp/shader_light.frag");
+	Shader perDraw(installed ? "shaders/shader_light.vs" : "../../OpenGLApp/shader_light.vs",
+		installed ? "shaders/shader_light.frag" : "../../OpenGLApp/shader_light.frag");
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+
+	// Same transforms for both runs: a grid of rotated, non uniformly scaled copies
+	std::vector<glm::mat4> transforms(instances);
+	for (int i = 0; i < instances; i++) {
+		glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3((i % 25) * 0.16f - 2.0f, (i / 25) * 0.12f - 1.2f, 0.0f));
+		m = glm::rotate(m, i * 0.37f, glm::vec3(0.3f, 1.0f, 0.1f));
+		m = glm::scale(m, glm::vec3(0.05f, 0.04f + (i % 7) * 0.005f, 0.05f));
+		transforms[i] = m;
+	}
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	Shader* variants[2] = { &perVertex, &perDraw };
+	const char* names[2] = { "per-vertex inverse()", "CPU normal matrix" };
+	double gpuMs[2];
+
+	for (int v = 0; v < 2; v++) {
+		Shader& shader = *variants[v];
+		shader.use();
+		shader.setMat4("view", view);
+		shader.setMat4("projection", projection);
+		shader.setVec3("light.position", lightPos);
+		shader.setVec3("light.color", glm::vec3(1.0f, 1.0f, 1.0f));
+		shader.setVec3("viewPos", glm::vec3(0.0f, 0.0f, 3.0f));
+
+		GLuint64 total = 0;
+		for (int frame = 0; frame < warmupFrames + frames; frame++) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			for (int i = 0; i < instances; i++) {
+				if (v == 0)
+					shader.setMat4("model", transforms[i]);
+				else
+					setModelMatrix(shader, transforms[i]);
+				model.Draw(shader);
+			}
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+			if (frame >= warmupFrames)
+				total += elapsed;
+			glfwPollEvents();
+		}
+		gpuMs[v] = total / 1.0e6 / frames;
+	}
+	glDeleteQueries(1, &query);
+
+	double vertices = static_cast<double>(model.IndexCount()) * instances;
+	std::cout << "Normal matrix benchmark: " << instances << " draws, " << vertices << " vertices per frame" << std::endl;
+	for (int v = 0; v < 2; v++) {
+		std::cout << "  " << names[v] << ": " << gpuMs[v] << " ms/frame, "
+			<< vertices / (gpuMs[v] * 1.0e3) << " Mvertices/s" << std::endl;
+	}
+	return 0;
+}
+
+// Screen space box around a devil that catches it when clicked.
+// min/max hold left/bottom and right/top in pixels
+AABB createDevilClickBox(const glm::vec3& position, float offsetX, float offsetY) {
+	float width = 30.0f;
+	float height = 30.0f;
+	return AABB{
+		glm::vec3((position.x - width) + offsetX, (position.y - height) + offsetY, 0.0f),
+		glm::vec3((position.x + width) + offsetX, (position.y + height) + offsetY, 0.0f)
+	};
+}
+
+// Queues a sound of soundSetups for the audio thread, nullptr plays nothing.
+// Called from the simulation thread only, the single producer of the audio queue
+void playSound(const char* name) {
+	audio.Post(name);
+}
+
+// Starts the audio thread on irrKlang, or on the null backend when silent is set or
+// no device can be opened, with every sound of soundSetups loaded
+void openAudio(bool silent, bool recordEvents) {
+	AudioBackend* backend = silent ? nullptr : IrrKlangAudioBackend::Create();
+	if (!backend) {
+		if (!silent) {
+			LOG_WARN("Could not initialize irrKlang sound engine, playing without sound");
+		}
+		backend = new NullAudioBackend();
+	}
+	audio.Open(backend);
+	for (const SoundSetup& setup : soundSetups) {
+		std::string path = std::string("../../OpenGLApp/sounds/") + setup.name;
+		if (!fileExists(path)) {
+			path = std::string("sounds/") + setup.name;
+		}
+		if (!audio.AddSound(setup.name, path, setup.policy)) {
+			LOG_ERROR("Could not load sound {}", setup.name);
+		}
+	}
+	audio.RecordEvents(recordEvents);
+	audio.Start();
+}
+
+// Starts the simulation thread if it is not running yet. The first snapshot is
+// published before the thread starts, so the frame that starts it can already draw it
+void startSimulation() {
+	if (simRunning) {
+		return;
+	}
+	// Nothing to interpolate from after a pause or a restart
+	snapshotHistoryValid = false;
+	publishSnapshot(glfwGetTime());
+	simRunning = true;
+	simThread = std::thread(simulationLoop);
+}
+
+// Joins the simulation thread, after which the gameplay globals belong to the main thread again
+void stopSimulation() {
+	if (!simRunning) {
+		return;
+	}
+	simRunning = false;
+	simThread.join();
+
+	// Input sampled for the stopped game must not leak into the next one
+	SimInput stale;
+	while (simInputs.TryPop(stale)) {
+	}
+
+	// Written at every pause as well, so the file also covers games that never end
+	if (recordingInput && !inputRecording.Save(recordingPath)) {
+		LOG_ERROR("Failed to write recording {}", recordingPath.c_str());
+	}
+}
+
+void simulationLoop() {
+	double nextTick = glfwGetTime();
+	SimInput held;
+
+	while (simRunning) {
+		double now = glfwGetTime();
+		if (now < nextTick) {
+			std::this_thread::sleep_for(std::chrono::duration<double>(nextTick - now));
+			continue;
+		}
+
+		// Held keys use the newest sample, fire and click are presses: each one counts
+		// in exactly one tick, however many ticks run per frame
+		SimInput input;
+		SimInput sample;
+		while (simInputs.TryPop(sample)) {
+			held.left = sample.left;
+			held.right = sample.right;
+			input.fire = input.fire || sample.fire;
+			if (sample.click) {
+				input.click = true;
+				input.mouseX = sample.mouseX;
+				input.mouseY = sample.mouseY;
+			}
+		}
+		input.left = held.left;
+		input.right = held.right;
+
+		stepSimulation(input);
+		publishSnapshot(nextTick);
+		nextTick += SimStep;
+
+		// After a long stall (debugger, dragged window) skip the missed ticks instead of replaying them
+		if (glfwGetTime() - nextTick > 0.25) {
+			nextTick = glfwGetTime();
+		}
+	}
+}
+
+// Advances the game clock by one tick. A replay replaces the sampled input with the
+// recorded one, a recording logs the input the tick actually used
+void stepSimulation(SimInput input) {
+	if (replayingInput) {
+		InputRecording::Tick tick;
+		if (inputReplay.Next(tick)) {
+			input.left = (tick.flags & InputRecording::Left) != 0;
+			input.right = (tick.flags & InputRecording::Right) != 0;
+			input.fire = (tick.flags & InputRecording::Fire) != 0;
+			input.click = (tick.flags & InputRecording::Click) != 0;
+			input.mouseX = tick.mouseX;
+			input.mouseY = tick.mouseY;
+		}
+		else {
+			// The player takes over where the recording ends
+			replayingInput = false;
+			LOG_INFO("Replay finished at {}s", gameTime);
+		}
+	}
+	if (recordingInput) {
+		InputRecording::Tick tick;
+		tick.flags = (input.left ? InputRecording::Left : 0) | (input.right ? InputRecording::Right : 0) |
+			(input.fire ? InputRecording::Fire : 0) | (input.click ? InputRecording::Click : 0);
+		if (input.click) {
+			tick.mouseX = input.mouseX;
+			tick.mouseY = input.mouseY;
+		}
+		inputRecording.Append(tick);
+	}
+
+	simulateGame(input, static_cast<float>(gameTime), static_cast<float>(SimStep));
+	gameTime += SimStep;
+}
+
+// One fixed step of the game rules. Runs on the simulation thread and never touches GL
+void simulateGame(const SimInput& input, float currentTime, float dt) {
+	float vibrationTimer = 0.0f;
+
+	// Plate movement and powerups
+	if (input.right) {
+		if (platePosition.x <= 0.45f)
+			platePosition.x += 1.0f * dt;
+		else {
+			platePosition.x = 0.45f;
+		}
+	}
+	if (input.left) {
+		if (platePosition.x >= -0.45f)
+			platePosition.x -= 1.0f * dt;
+		else {
+			platePosition.x = -0.45f;
+		}
+	}
+	if (input.fire) {
+		if (collectedPowerupId == PowerupInvincibility && !powerupActive) {
+			activePowerupId = 0;
+			powerupStartTime = currentTime;
+			powerupActive = true;
+			LOG_INFO("Power-up {} attivato!", collectedPowerupId);
+		}
+		else if (collectedPowerupId == PowerupRockets && !powerupActive) {
+			activePowerupId = 1;
+			powerupStartTime = currentTime;
+			powerupActive = true;
+			LOG_INFO("Power-up {} attivato!", collectedPowerupId);
+		}
+		else if (collectedPowerupId == PowerupRockets && powerupActive) {
+			createFlyingObject();
+		}
+	}
+
+	// Handle continuous cube appearance
+	if (stressActive) {
+		spawnStress(dt);
+	}
+	else if (currentTime >= pastDifficulty + increaseDifficulty) {
+		if (level > 1) cubeSpeed += 0.003f / level;
+		delay -= 0.5f / level;
+		pastDifficulty = currentTime;
+		level++;
+	}
+
+	if (!stressActive && currentTime >= pastTime + delay) {
+		// keep adding cubes
+		Food food;
+		food.type = -1; // required inizialization
+		food.type = generateRandomObject();
+		food.position = generateRandomPosition(food);
+		foods.push_back(food);
+
+		LOG_DEBUG("Spawned at {} with speed {} with delay {}, game time {}", currentTime, cubeSpeed, delay, pastTime);
+		if (itemTypes[food.type].clickable) {
+			randomY = getRandomNumberY();
+			randomX = getRandomNumberX();
+		}
+		if (!itemTypes[food.type].laser) numberOfObject++;
+		pastTime = currentTime;
+	}
+
+	if (powerupActive && (activePowerupId == PowerupInvincibility || activePowerupId == PowerupRockets)) {
+		float powerupElapsedTime = currentTime - powerupStartTime;
+
+		if (powerupElapsedTime >= powerupDuration) {
+			collectedPowerupId = -1;
+			activePowerupId = -1;
+			powerupActive = false;
+			LOG_INFO("Power-up scaduto!");
+			powerupLabel = "None";
+		}
+	}
+
+	// Motion and plate tests run in parallel, the responses below in item order
+	moveItems(*jobSystem, foods, cubeSpeed, dt, createPlateAABB(platePosition), itemMotion);
+
+	for (unsigned int i = 0; i < foods.size(); i++) {
+		if (itemMotion[i] == ItemInactive) {
+			continue;
+		}
+
+		const ItemType& itemType = itemTypes[foods[i].type];
+
+		// Check for collision
+		if (itemMotion[i] == ItemHitPlate) {
+			foods[i].position.y = -10.0f;
+			if (itemType.hurts) {
+				if (activePowerupId != PowerupInvincibility && !stressActive) {
+					lives--;
+					playSound(itemType.hurtSound);
+					isVibrating = true;
+					vibrationTimer = currentTime;
+				}
+			}
+			else {
+				if (itemType.powerup >= 0) {
+					collectedPowerupId = itemType.powerup;
+					powerupLabel = itemType.powerupLabel;
+				}
+				numberOfCollisions++;
+				playSound(itemType.collectSound);
+			}
+		}
+
+		if (itemType.laser) {
+			// The alien follows the laser it fired
+			alienPosition.x = foods[i].position.x;
+		}
+		else if (itemType.clickable && input.click) {
+			AABB clickBox = createDevilClickBox(foods[i].position, randomX, randomY);
+			if (input.mouseX >= clickBox.min.x && input.mouseX <= clickBox.max.x && input.mouseY <= clickBox.max.y && input.mouseY >= clickBox.min.y)
+			{
+				LOG_DEBUG("Preso!");
+				numberOfCollisions++;
+				foods[i].position.y = -10.0f;
+				playSound(itemType.collectSound);
+			}
+		}
+	}
+
+	moveRockets(*jobSystem, flyingObjects, foods, dt, rocketHits);
+
+	for (unsigned int i = 0; i < flyingObjects.size(); i++) {
+		if (rocketHits[i] < 0) {
+			continue;
+		}
+
+		// An earlier rocket may have taken this laser already, then look further
+		AABB rocketAABB = createRocketAABB(flyingObjects[i].position, flyingObjects[i].size);
+		for (unsigned int j = rocketHits[i]; j < foods.size(); j++) {
+			if (foods[j].type != ItemRemoved && itemTypes[foods[j].type].laser) {
+
+				// Crea laser AABB
+				AABB laserAABB = createAABB(foods[j].position);
+
+				if (checkCollision(rocketAABB, laserAABB) && !flyingObjects[i].collided) {
+					LOG_DEBUG("Collisione tra razzo e laser!");
+
+					foods[j].type = ItemRemoved; // Deactivate il laser
+					flyingObjects[i].collided = true;
+					flyingObjects[i].position = glm::vec3{ -10, -10, -10 };
+					break;
+				}
+			}
+		}
+	}
+
+	// Plate vibration after a hit
+	if (isVibrating) {
+		float elapsedTime = currentTime - vibrationTimer;
+		float offsetVib = sin(elapsedTime * 50.0f) * vibrationIntensity;
+
+		if (elapsedTime < vibrationDuration) {
+			platePosition.x += offsetVib;
+		}
+		else {
+			platePosition.x += offsetVib / 2;
+			isVibrating = false;
+		}
+	}
+}
+
+// Copies the gameplay globals into the write side of gameSnapshots and hands it to the renderer.
+// Called by whichever thread currently owns the gameplay state
+void publishSnapshot(double time) {
+	GameSnapshot& snapshot = gameSnapshots.WriteBuffer();
+	snapshot.time = time;
+	snapshot.gameTime = gameTime;
+
+	// Positions of the last published tick, indexed like foods and flyingObjects
+	if (!snapshotHistoryValid) {
+		itemHistory.clear();
+		rocketHistory.clear();
+		plateHistory = platePosition;
+		snapshotHistoryValid = true;
+	}
+
+	snapshot.items.clear();
+	for (unsigned int i = 0; i < foods.size(); i++) {
+		glm::vec3 previous = i < itemHistory.size() ? itemHistory[i] : foods[i].position;
+		if (foods[i].position.y > -1.10f && foods[i].type != ItemRemoved) {
+			snapshot.items.push_back({ previous, foods[i].position, foods[i].type });
+		}
+	}
+	snapshot.rockets.clear();
+	for (unsigned int i = 0; i < flyingObjects.size(); i++) {
+		glm::vec3 previous = i < rocketHistory.size() ? rocketHistory[i] : flyingObjects[i].position;
+		if (!flyingObjects[i].collided) {
+			snapshot.rockets.push_back({ previous, flyingObjects[i].position, flyingObjects[i].type });
+		}
+	}
+	snapshot.plate = { plateHistory, platePosition, 0 };
+
+	itemHistory.resize(foods.size());
+	for (unsigned int i = 0; i < foods.size(); i++) {
+		itemHistory[i] = foods[i].position;
+	}
+	rocketHistory.resize(flyingObjects.size());
+	for (unsigned int i = 0; i < flyingObjects.size(); i++) {
+		rocketHistory[i] = flyingObjects[i].position;
+	}
+	plateHistory = platePosition;
+
+	snapshot.alienPosition = alienPosition;
+	snapshot.clickOffsetX = randomX;
+	snapshot.clickOffsetY = randomY;
+	snapshot.powerupActive = powerupActive;
+	snapshot.collected = numberOfCollisions;
+	snapshot.dropped = numberOfObject;
+	snapshot.lives = lives;
+	snapshot.powerupLabel = powerupLabel;
+
+	gameSnapshots.Publish();
+}
+
+// Hands the held movement keys and this frame's fire and click presses to the simulation thread
+void sampleSimInput() {
+	SimInput input;
+	// | rather than || so the presses of both keys are stamped
+	input.right = inputEvents.Down(GLFW_KEY_D) | inputEvents.Down(GLFW_KEY_RIGHT);
+	input.left = inputEvents.Down(GLFW_KEY_A) | inputEvents.Down(GLFW_KEY_LEFT);
+	input.fire = inputEvents.Pressed(GLFW_KEY_SPACE);
+
+	double xpos, ypos;
+	input.click = inputEvents.Clicked(GLFW_MOUSE_BUTTON_LEFT, xpos, ypos);
+	if (input.click) {
+		// Convert mouse coordinates
+		input.mouseX = xpos * (static_cast<float>(SCR_WIDTH) / windowWidth);
+		input.mouseY = (windowHeight - ypos) * (static_cast<float>(SCR_HEIGHT) / windowHeight);
+	}
+
+	// A full queue means the simulation is stalled; held keys come back with the next
+	// sample, a press lost here is not
+	simInputs.TryPush(input);
+}
+
+// Derives the TransformBuilder shapes from the item table, every item spins around Y
+void initItemShapes() {
+	for (int t = 0; t < ItemTypeCount; t++) {
+		itemShapes[t].scale = itemTypes[t].scale;
+		itemShapes[t].axis = glm::vec3(0.0f, 1.0f, 0.0f);
+		itemShapes[t].spins = itemTypes[t].spins;
+	}
+}
+
+// Counts a draw that went through frustum culling in the frame stats
+void countDraw(bool visible) {
+	if (visible)
+		frameStats.drawsVisible++;
+	else
+		frameStats.drawsCulled++;
+}
+
+// Moves the falling items and classifies each one for the response pass.
+// Every range only writes its own items, so it can run on any thread
+void moveItems(JobSystem& jobs, std::vector<Food>& items, float speed, float dt, const AABB& plateAABB, std::vector<char>& hits) {
+	hits.resize(items.size());
+	jobs.ParallelFor(items.size(), ItemGrain, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			items[i].position.z = 0.2f;
+			if (items[i].position.y <= -1.10f || items[i].type == ItemRemoved) {
+				hits[i] = ItemInactive;
+				continue;
+			}
+			items[i].position.y -= speed * dt;
+			hits[i] = checkCollision(createAABB(items[i].position), plateAABB) ? ItemHitPlate : ItemMoved;
+		}
+	});
+}
+
+// Moves the rockets and stores the first laser each one overlaps (-1 for none).
+// Lasers are only read here, the hits are applied in order afterwards
+void moveRockets(JobSystem& jobs, std::vector<FlyingObject>& rockets, const std::vector<Food>& items, float dt, std::vector<int>& hits) {
+	hits.resize(rockets.size());
+	jobs.ParallelFor(rockets.size(), RocketGrain, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			rockets[i].position.y += rockets[i].speedY * dt;
+			rockets[i].position.z = 0.2f;
+			hits[i] = -1;
+			if (rockets[i].collided) {
+				continue;
+			}
+			AABB rocketAABB = createRocketAABB(rockets[i].position, rockets[i].size);
+			for (size_t j = 0; j < items.size(); j++) {
+				if (items[j].type != ItemRemoved && itemTypes[items[j].type].laser && checkCollision(rocketAABB, createAABB(items[j].position))) {
+					hits[i] = static_cast<int>(j);
+					break;
+				}
+			}
+		}
+	});
+}
+
+// Interpolates and culls the snapshot items, then builds model matrices for the
+// visible ones only: they are packed in item order before the batched build.
+// Normal matrices only depend on the type and come from instances.transforms
+void prepareItemDraws(JobSystem& jobs, const std::vector<BodySnapshot>& items, float alpha, float angle, const Frustum& frustum, ItemInstances& instances) {
+	size_t count = items.size();
+	instances.draws.resize(count);
+	instances.transforms.Prepare(itemShapes, ItemTypeCount, angle);
+
+	jobs.ParallelFor(count, ItemGrain, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const BodySnapshot& item = items[i];
+			ItemDraw& draw = instances.draws[i];
+			draw.position = glm::mix(item.previous, item.position, alpha);
+			draw.visible = frustum.IntersectsSphere(draw.position, itemCullRadii[item.type]);
+		}
+	});
+
+	instances.xs.clear();
+	instances.ys.clear();
+	instances.zs.clear();
+	instances.types.clear();
+	for (size_t i = 0; i < count; i++) {
+		ItemDraw& draw = instances.draws[i];
+		if (!draw.visible) {
+			continue;
+		}
+		draw.matrix = static_cast<unsigned int>(instances.xs.size());
+		instances.xs.push_back(draw.position.x);
+		instances.ys.push_back(draw.position.y);
+		instances.zs.push_back(draw.position.z);
+		instances.types.push_back(items[i].type);
+	}
+
+	size_t visible = instances.xs.size();
+	instances.models.resize(visible);
+	jobs.ParallelFor(visible, ItemGrain, [&](size_t begin, size_t end) {
+		instances.transforms.Build(instances.xs.data(), instances.ys.data(), instances.zs.data(), instances.types.data(), begin, end, instances.models.data());
+	});
+}
+
+// Runs the parallel item stages on a stress scene with 1 to N threads and prints the frame times.
+// Needs no window, it runs before GLFW is initialized
+int runJobSystemBenchmark() {
+	const size_t itemCount = 200000;
+	const size_t rocketCount = 200;
+	const int warmupFrames = 3;
+	const int frames = 30;
+	const float dt = static_cast<float>(SimStep);
+
+	std::mt19937 gen(1234);
+	std::uniform_real_distribution<float> x(-0.5f, 0.5f);
+	std::uniform_real_distribution<float> y(-1.0f, 1.2f);
+	std::uniform_int_distribution<int> type(0, ItemTypeCount - 1);
+
+	std::vector<Food> scene(itemCount);
+	for (size_t i = 0; i < itemCount; i++) {
+		scene[i].position = glm::vec3(x(gen), y(gen), 0.2f);
+		do {
+			scene[i].type = type(gen);
+		} while (itemTypes[scene[i].type].rocket);
+	}
+	std::vector<FlyingObject> rocketScene(rocketCount);
+	for (size_t i = 0; i < rocketCount; i++) {
+		rocketScene[i].position = glm::vec3(x(gen), y(gen), 0.2f);
+		rocketScene[i].speedY = 0.8f;
+		rocketScene[i].size = RocketSize;
+		rocketScene[i].type = rocketItemType();
+	}
+	for (int t = 0; t < ItemTypeCount; t++) {
+		itemCullRadii[t] = itemTypes[t].scale;
+	}
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(projection * view);
+	AABB plateAABB = createPlateAABB(glm::vec3(0.0f, -1.10f, 0.2f));
+
+	unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	double singleThreadMs = 0.0;
+	std::cout << "Job system benchmark: " << itemCount << " items, " << rocketCount << " rockets" << std::endl;
+
+	for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+		JobSystem jobs(threads - 1);
+		std::vector<Food> items = scene;
+		std::vector<FlyingObject> rockets = rocketScene;
+		std::vector<char> itemHits;
+		std::vector<int> rocketHits;
+		ItemInstances instances;
+
+		// The first frame interpolates from the starting positions, not from garbage
+		std::vector<BodySnapshot> bodies(itemCount);
+		for (size_t i = 0; i < itemCount; i++) {
+			bodies[i].position = items[i].position;
+			bodies[i].previous = items[i].position;
+			bodies[i].type = items[i].type;
+		}
+
+		double totalMs = 0.0;
+		for (int frame = 0; frame < warmupFrames + frames; frame++) {
+			// Publishing the snapshot is serial and not part of the measured stages
+			for (size_t i = 0; i < itemCount; i++) {
+				bodies[i].previous = bodies[i].position;
+				bodies[i].position = items[i].position;
+				bodies[i].type = items[i].type;
+			}
+			auto start = std::chrono::high_resolution_clock::now();
+
+			moveItems(jobs, items, 0.8f, dt, plateAABB, itemHits);
+			moveRockets(jobs, rockets, items, dt, rocketHits);
+			prepareItemDraws(jobs, bodies, 0.5f, frame * dt, frustum, instances);
+
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+			if (frame >= warmupFrames)
+				totalMs += elapsed.count();
+		}
+
+		double ms = totalMs / frames;
+		if (threads == 1)
+			singleThreadMs = ms;
+		std::cout << "  " << threads << " thread(s): " << ms << " ms/frame, speedup " << singleThreadMs / ms << "x" << std::endl;
+	}
+	return 0;
+}
+
+// Builds the item model matrices of a large random scene with the old per-item
+// glm calls and with TransformBuilder, and prints the time per item of both
+int runTransformBenchmark() {
+	const size_t count = 100000;
+	const int rounds = 50;
+
+	std::mt19937 gen(1234);
+	std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+	std::uniform_int_distribution<int> type(0, ItemTypeCount - 1);
+	std::vector<float> xs(count), ys(count), zs(count);
+	std::vector<int> types(count);
+	for (size_t i = 0; i < count; i++) {
+		xs[i] = coordinate(gen);
+		ys[i] = coordinate(gen);
+		zs[i] = 0.2f;
+		types[i] = type(gen);
+	}
+
+	std::vector<glm::mat4> reference(count), batched(count);
+	TransformBuilder builder;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < rounds; r++) {
+		float angle = r * 0.01f;
+		for (size_t i = 0; i < count; i++) {
+			const InstanceShape& shape = itemShapes[types[i]];
+			glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(xs[i], ys[i], zs[i]));
+			m = glm::scale(m, glm::vec3(shape.scale, shape.scale, shape.scale));
+			if (shape.spins)
+				m = glm::rotate(m, angle, shape.axis);
+			reference[i] = m;
+		}
+	}
+	std::chrono::duration<double, std::nano> perItem = std::chrono::high_resolution_clock::now() - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < rounds; r++) {
+		builder.Prepare(itemShapes, ItemTypeCount, r * 0.01f);
+		builder.Build(xs.data(), ys.data(), zs.data(), types.data(), 0, count, batched.data());
+	}
+	std::chrono::duration<double, std::nano> batch = std::chrono::high_resolution_clock::now() - start;
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; i++) {
+		for (int c = 0; c < 4; c++) {
+			glm::vec4 d = glm::abs(reference[i][c] - batched[i][c]);
+			maxError = std::max(maxError, std::max(std::max(d.x, d.y), std::max(d.z, d.w)));
+		}
+	}
+
+	double items = static_cast<double>(count) * rounds;
+	std::cout << "Transform benchmark: " << count << " items x " << rounds << " rounds" << std::endl;
+	std::cout << "  per-item glm: " << perItem.count() / items << " ns/item" << std::endl;
+	std::cout << "  batched SoA:  " << batch.count() / items << " ns/item (" << perItem.count() / batch.count() << "x)" << std::endl;
+	std::cout << "  max difference: " << maxError << std::endl;
+	return 0;
+}
+
+// Replays a recording without window, sound device or clock, as fast as the rules run.
+// The final counters match the rendered game that was recorded; the sounds go to the
+// null backend and are listed with their latency
+int runHeadlessReplay(const std::string& path) {
+	if (!inputReplay.Load(path, static_cast<int>(DifficultyLevel::Easy), static_cast<int>(DifficultyLevel::Hard))) {
+		std::cout << "Failed to load replay " << path << std::endl;
+		return -1;
+	}
+
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	jobSystem = new JobSystem(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+	openAudio(true, true);
+
+	currentDifficulty = static_cast<DifficultyLevel>(inputReplay.Difficulty());
+	startGame(inputReplay.Seed());
+	replayingInput = true;
+
+	uint64_t ticks = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (ticks < inputReplay.TickCount() && lives > 0) {
+		stepSimulation(SimInput());
+		ticks++;
+	}
+	double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	GameLog().Flush();
+
+	std::cout << "Replay " << path << " (seed " << gameSeed << ")" << std::endl;
+	std::cout << "  ticks: " << ticks << " of " << inputReplay.TickCount() << ", game time " << gameTime << "s" << std::endl;
+	std::cout << "  wall time: " << wallMs << " ms, " << (wallMs > 0.0 ? ticks * 1000.0 / wallMs : 0.0) << " ticks/s" << std::endl;
+	std::cout << "  collected: " << numberOfCollisions << ", dropped: " << numberOfObject << ", lives: " << lives << std::endl;
+
+	audio.Stop();
+	AudioSystem::Counters sound = audio.Stats();
+	std::cout << "  sounds: " << audio.Events().size() << " events, " << sound.pool.played << " played, " << sound.pool.coalesced << " coalesced, "
+		<< sound.pool.dropped << " dropped, " << sound.pool.stolen << " stolen, " << sound.queueFull << " lost in the queue" << std::endl;
+	std::cout << "  sound latency: " << sound.meanLatency * 1000.0 << " ms mean, " << sound.maxLatency * 1000.0 << " ms max" << std::endl;
+	for (size_t s = 0; s < sizeof(soundSetups) / sizeof(soundSetups[0]); s++) {
+		size_t fired = 0;
+		for (const AudioEvent& event : audio.Events()) {
+			if (event.sound >= 0 && std::string(audio.SoundName(event.sound)) == soundSetups[s].name) {
+				fired++;
+			}
+		}
+		std::cout << "    " << soundSetups[s].name << ": " << fired << std::endl;
+	}
+	audio.Close();
+
+	delete jobSystem;
+	jobSystem = nullptr;
+	return 0;
+}
+
+// Calls body batch times per sample and reports the time per call as JSON.
+// Allocations are counted on the calling thread and averaged per call; without
+// OPENGLAPP_BENCH_ALLOC they are not counted and reported as null
+template <typename F>
+json measureBenchmark(const char* name, int samples, int batch, const F& body) {
+	for (int i = 0; i < batch; i++) {
+		body();
+	}
+
+	std::vector<double> perCall(samples);
+	size_t allocations = 0;
+	for (int s = 0; s < samples; s++) {
+		size_t allocationsBefore = countedAllocations();
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < batch; i++) {
+			body();
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		allocations += countedAllocations() - allocationsBefore;
+		perCall[s] = ns / batch;
+	}
+	std::sort(perCall.begin(), perCall.end());
+
+	json result;
+	result["name"] = name;
+	result["samples"] = samples;
+	result["batch"] = batch;
+	result["min_ns"] = perCall.front();
+	result["median_ns"] = perCall[samples / 2];
+	result["p99_ns"] = perCall[std::min(samples - 1, samples * 99 / 100)];
+#ifdef OPENGLAPP_BENCH_ALLOC
+	result["allocations_per_call"] = static_cast<double>(allocations) / (static_cast<double>(samples) * batch);
+#else
+	result["allocations_per_call"] = nullptr;
+#endif
+	return result;
+}
+
+// Bakes every configuration once with jobs and reports the wall time and the time of each
+json measureFontBake(const char* name, JobSystem& jobs, const std::vector<FontBakeConfig>& configs) {
+	std::vector<FontAtlas> atlases(configs.size());
+	std::vector<FontAtlas*> targets;
+	for (FontAtlas& atlas : atlases) {
+		targets.push_back(&atlas);
+	}
+	std::vector<FontBakeTiming> timings;
+	double wallMs = BakeFontAtlases(jobs, configs, targets.data(), timings);
+
+	json result;
+	result["name"] = name;
+	result["workers"] = jobs.WorkerCount();
+	result["wall_ms"] = wallMs;
+	json perConfig = json::array();
+	for (size_t i = 0; i < configs.size(); i++) {
+		json config;
+		config["font"] = configs[i].path.substr(configs[i].path.rfind('/') + 1);
+		config["weight"] = configs[i].weight;
+		config["pixel_size"] = configs[i].pixelSize;
+		config["render"] = configs[i].render == GlyphRender::Coverage ? "coverage" : "sdf";
+		config["glyphs"] = timings[i].glyphs;
+		config["raster_ms"] = timings[i].rasterMs;
+		config["build_ms"] = timings[i].buildMs;
+		perConfig.push_back(config);
+	}
+	result["configurations"] = perConfig;
+	return result;
+}
+
+// Microbenchmarks of the functions the game calls every tick or frame, plus score
+// saving, font atlas building and mesh loading. Prints one JSON document and writes it to outputPath if given
+int runBenchmarkSuite(Model& model, const std::string& modelPath, const std::string& fontPath, const char* outputPath) {
+	const int samples = 200;
+	const int batch = 1000;
+	volatile float sink = 0.0f;
+
+	// Fixed inputs so runs of different versions compare
+	std::mt19937 gen(1234);
+	std::uniform_real_distribution<float> coordinate(-1.2f, 1.2f);
+	std::vector<glm::vec3> positions(1024);
+	std::vector<AABB> boxes(positions.size());
+	for (unsigned int i = 0; i < positions.size(); i++) {
+		positions[i] = glm::vec3(coordinate(gen), coordinate(gen), 0.2f);
+		boxes[i] = createAABB(positions[i]);
+	}
+	const size_t mask = positions.size() - 1;
+	size_t next = 0;
+
+	json benchmarks = json::array();
+	benchmarks.push_back(measureBenchmark("checkCollision", samples, batch, [&]() {
+		sink = sink + checkCollision(boxes[next & mask], boxes[(next * 7 + 1) & mask]);
+		next++;
+	}));
+	benchmarks.push_back(measureBenchmark("createAABB", samples, batch, [&]() {
+		sink = sink + createAABB(positions[next++ & mask]).max.x;
+	}));
+	benchmarks.push_back(measureBenchmark("createPlateAABB", samples, batch, [&]() {
+		sink = sink + createPlateAABB(positions[next++ & mask]).max.y;
+	}));
+	benchmarks.push_back(measureBenchmark("createRocketAABB", samples, batch, [&]() {
+		sink = sink + createRocketAABB(positions[next++ & mask], RocketSize).max.x;
+	}));
+	benchmarks.push_back(measureBenchmark("createDevilClickBox", samples, batch, [&]() {
+		sink = sink + createDevilClickBox(positions[next++ & mask], 600.0f, 100.0f).max.x;
+	}));
+
+	startGame(1234);
+	benchmarks.push_back(measureBenchmark("generateRandomPosition", samples, batch, [&]() {
+		Food food;
+		food.type = static_cast<int>(next++ % ItemTypeCount);
+		sink = sink + generateRandomPosition(food).x;
+	}));
+	benchmarks.push_back(measureBenchmark("generateRandomObject", samples, batch, [&]() {
+		sink = sink + static_cast<float>(generateRandomObject());
+	}));
+
+	const std::string hudText = "Object collected: 1234";
+	std::vector<float> textVertices(hudText.size() * 6 * TextVertexFloats);
+	benchmarks.push_back(measureBenchmark("layoutText", samples, batch, [&]() {
+		layoutText(hudText, 10.0f, 550.0f, 0.6f, textVertices.data());
+		sink = sink + textVertices[0];
+	}));
+
+	// Its own file, the player's score.json stays untouched
+	const std::string scorePath = "bench_score.json";
+	int collected = 42, dropped = 17;
+	float timePlayed = 93.5f;
+	benchmarks.push_back(measureBenchmark("saveScore", 50, 10, [&]() {
+		saveScore(collected, dropped, timePlayed, scorePath);
+	}));
+	benchmarks.push_back(measureBenchmark("loadScores", 50, 10, [&]() {
+		int lastCollected, lastDropped, bestCollected, bestDropped;
+		float lastTime, bestTime;
+		loadScores(lastCollected, lastDropped, lastTime, bestCollected, bestDropped, bestTime, scorePath);
+		sink = sink + lastTime;
+	}));
+	std::remove(scorePath.c_str());
+
+	// Opening the font and rasterizing the printable ASCII glyphs on first use, for both
+	// atlas kinds, with the memory of the atlas pages and of the glyphs packed into them
+	const GlyphRender renders[] = { GlyphRender::Coverage, GlyphRender::DistanceField };
+	for (GlyphRender render : renders) {
+		size_t atlasBytes = 0;
+		size_t glyphBytes = 0;
+		json result = measureBenchmark(render == GlyphRender::Coverage ? "FontAtlas ASCII coverage" : "FontAtlas ASCII sdf", 10, 1, [&]() {
+			FontAtlas atlas;
+			atlas.Open(fontPath, 48, render, TextWeight);
+			for (uint32_t c = 32; c < 127; c++) {
+				atlas.Glyph(c);
+			}
+			atlasBytes = atlas.TextureBytes();
+			glyphBytes = atlas.GlyphBytes();
+		});
+		result["atlas_bytes"] = atlasBytes;
+		result["glyph_bytes"] = glyphBytes;
+		benchmarks.push_back(result);
+	}
+
+	// The same atlas from a baked file, one read and one upload instead of FreeType
+	const std::string bakedPath = "bench_font_cache.bin";
+	{
+		FontAtlas atlas;
+		atlas.Open(fontPath, 48, GlyphRender::DistanceField, TextWeight);
+		for (uint32_t c = 32; c < 127; c++) {
+			atlas.Glyph(c);
+		}
+		atlas.Save(bakedPath);
+	}
+	benchmarks.push_back(measureBenchmark("FontAtlas::Load baked sdf", 10, 1, [&]() {
+		FontAtlas atlas;
+		atlas.Load(bakedPath, fontPath, 48, GlyphRender::DistanceField, TextWeight);
+		sink = sink + static_cast<float>(atlas.ResidentGlyphs());
+	}));
+	std::remove(bakedPath.c_str());
+
+	// Four weights at two sizes plus the game's distance field atlas, once from the
+	// static files of the family and once from the variable font alone. Rasterized on
+	// the caller alone and then on every worker, timed per configuration
+	const std::string staticFamily = fontPath.substr(0, fontPath.rfind('/') + 1) + "static/Antonio-";
+	const char* weightNames[] = { "Thin", "Light", "Regular", "Bold" };
+	const float weights[] = { 100.0f, 300.0f, 400.0f, 700.0f };
+	std::vector<FontBakeConfig> staticConfigs;
+	std::vector<FontBakeConfig> variableConfigs;
+	for (int w = 0; w < 4; w++) {
+		const unsigned int sizes[] = { 24, 48 };
+		for (unsigned int size : sizes) {
+			staticConfigs.push_back(FontBakeConfig{ staticFamily + weightNames[w] + ".ttf", size, GlyphRender::Coverage, 0.0f, 32, 126 });
+			variableConfigs.push_back(FontBakeConfig{ fontPath, size, GlyphRender::Coverage, weights[w], 32, 126 });
+		}
+	}
+	staticConfigs.push_back(FontBakeConfig{ staticFamily + "Bold.ttf", 48, GlyphRender::DistanceField, 0.0f, 32, 126 });
+	variableConfigs.push_back(FontBakeConfig{ fontPath, 48, GlyphRender::DistanceField, TextWeight, 32, 126 });
+	const std::vector<FontBakeConfig>* configSets[] = { &staticConfigs, &variableConfigs };
+	JobSystem callerOnly(0);
+	JobSystem* bakers[] = { &callerOnly, jobSystem };
+	for (const std::vector<FontBakeConfig>* configSet : configSets) {
+		for (JobSystem* bakeJobs : bakers) {
+			const char* name = configSet == &staticConfigs ? "BakeFontAtlases static" : "BakeFontAtlases variable";
+			benchmarks.push_back(measureFontBake(name, *bakeJobs, *configSet));
+		}
+	}
+
+	// The four weights at 24 px on the GL thread: one static file per weight against
+	// instances of the variable font read once
+	benchmarks.push_back(measureBenchmark("FontAtlas static weights", 5, 1, [&]() {
+		for (int w = 0; w < 4; w++) {
+			FontAtlas atlas;
+			atlas.Open(staticFamily + weightNames[w] + ".ttf", 24, GlyphRender::Coverage);
+			for (uint32_t c = 32; c < 127; c++) {
+				atlas.Glyph(c);
+			}
+		}
+	}));
+	benchmarks.push_back(measureBenchmark("FontFamily variable weights", 5, 1, [&]() {
+		FontFamily variable;
+		variable.Open(fontPath);
+		for (int w = 0; w < 4; w++) {
+			FontAtlas* atlas = variable.Instance(weights[w], 24, GlyphRender::Coverage);
+			for (uint32_t c = 32; atlas && c < 127; c++) {
+				atlas->Glyph(c);
+			}
+		}
+	}));
+
+	// Vertex and index conversion plus the GL upload of every mesh of the model
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(modelPath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals);
+	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+		std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+		return -1;
+	}
+	benchmarks.push_back(measureBenchmark("Model::processMesh", 50, 1, [&]() {
+		for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+			Mesh mesh = model.processMesh(scene->mMeshes[i], scene);
+			sink = sink + static_cast<float>(mesh.indices.size());
+			mesh.Release();
+		}
+	}));
+	GLState().Invalidate();
+
+	// CPU side of drawing every mesh of the model: material, texture and VAO binds and the draw call
+	ourShader->use();
+	benchmarks.push_back(measureBenchmark("Model::Draw", samples, 10, [&]() {
+		model.Draw(*ourShader);
+	}));
+	glFinish();
+
+	json report;
+	report["suite"] = "OpenGLApp";
+	report["model"] = modelPath;
+	report["benchmarks"] = benchmarks;
+	std::cout << report.dump(2) << std::endl;
+
+	if (outputPath) {
+		std::ofstream file(outputPath);
+		if (!file) {
+			std::cout << "Failed to write " << outputPath << std::endl;
+			return -1;
+		}
+		file << report.dump(2) << std::endl;
+	}
+	return 0;
+}
+
+// Starts a game that spawns at the rates of stressConfig
+void startStressGame() {
+	startGame();
+	stressActive = true;
+	scoredGame = false;
+	stressSpawns = StressSpawns();
+	stressStats = StressStats();
+	currentState = GameState::Game;
+	std::cout << "Stress test: " << stressConfig.itemsPerSecond << " items/s, " << stressConfig.lasersPerSecond << " lasers/s, "
+		<< stressConfig.rocketsPerSecond << " rockets/s for " << stressConfig.duration << "s" << std::endl;
+}
+
+// Stress mode spawning for one tick, on the simulation thread
+void spawnStress(float dt) {
+	static_assert(laserItemType() >= 0, "stress mode spawns lasers");
+
+	stressSpawns.items += stressConfig.itemsPerSecond * dt;
+	for (; stressSpawns.items >= 1.0; stressSpawns.items -= 1.0) {
+		Food food;
+		food.type = generateWeightedObject();
+		food.position = generateRandomPosition(food);
+		foods.push_back(food);
+		numberOfObject++;
+		stressSpawns.spawnedItems++;
+	}
+
+	stressSpawns.lasers += stressConfig.lasersPerSecond * dt;
+	for (; stressSpawns.lasers >= 1.0; stressSpawns.lasers -= 1.0) {
+		Food food;
+		food.type = laserItemType();
+		food.position = generateRandomPosition(food);
+		foods.push_back(food);
+		stressSpawns.spawnedLasers++;
+	}
+
+	// Rockets start along the whole plate range instead of all from the plate
+	std::uniform_real_distribution<float> rocketX(-0.45f, 0.45f);
+	stressSpawns.rockets += stressConfig.rocketsPerSecond * dt;
+	for (; stressSpawns.rockets >= 1.0; stressSpawns.rockets -= 1.0) {
+		createFlyingObject();
+		flyingObjects.back().position.x = rocketX(gameRng);
+		stressSpawns.spawnedRockets++;
+	}
+}
+
+// Frame time and live entities of one stress frame, on the main thread
+void recordStressFrame(const GameSnapshot& snapshot) {
+	double now = glfwGetTime();
+	if (stressStats.lastFrame > 0.0) {
+		stressStats.frameMs.push_back(static_cast<float>((now - stressStats.lastFrame) * 1000.0));
+		stressStats.peakItems = std::max(stressStats.peakItems, snapshot.items.size());
+		stressStats.peakRockets = std::max(stressStats.peakRockets, snapshot.rockets.size());
+		stressStats.itemSum += snapshot.items.size();
+		stressStats.rocketSum += snapshot.rockets.size();
+	}
+	stressStats.lastFrame = now;
+}
+
+// Writes the stress report once the simulation stopped. Returns 0 on success
+int finishStressGame() {
+	stressActive = false;
+
+	std::vector<float> sorted = stressStats.frameMs;
+	std::sort(sorted.begin(), sorted.end());
+	size_t frames = sorted.size();
+	double totalMs = 0.0;
+	for (size_t i = 0; i < frames; i++) {
+		totalMs += sorted[i];
+	}
+	auto percentile = [&](double p) {
+		return frames ? sorted[std::min(frames - 1, static_cast<size_t>(p * frames))] : 0.0f;
+	};
+
+	json report;
+	report["config"]["items_per_second"] = stressConfig.itemsPerSecond;
+	report["config"]["lasers_per_second"] = stressConfig.lasersPerSecond;
+	report["config"]["rockets_per_second"] = stressConfig.rocketsPerSecond;
+	report["config"]["duration_s"] = stressConfig.duration;
+	report["config"]["seed"] = gameSeed;
+	report["frames"] = frames;
+	report["average_fps"] = totalMs > 0.0 ? frames * 1000.0 / totalMs : 0.0;
+	report["frame_ms"]["min"] = frames ? sorted.front() : 0.0f;
+	report["frame_ms"]["p50"] = percentile(0.50);
+	report["frame_ms"]["p90"] = percentile(0.90);
+	report["frame_ms"]["p99"] = percentile(0.99);
+	report["frame_ms"]["max"] = frames ? sorted.back() : 0.0f;
+	report["entities"]["spawned_items"] = stressSpawns.spawnedItems;
+	report["entities"]["spawned_lasers"] = stressSpawns.spawnedLasers;
+	report["entities"]["spawned_rockets"] = stressSpawns.spawnedRockets;
+	report["entities"]["peak_live_items"] = stressStats.peakItems;
+	report["entities"]["peak_live_rockets"] = stressStats.peakRockets;
+	report["entities"]["mean_live_items"] = frames ? stressStats.itemSum / frames : 0.0;
+	report["entities"]["mean_live_rockets"] = frames ? stressStats.rocketSum / frames : 0.0;
+	report["entities"]["stored_items"] = foods.size();
+	report["entities"]["stored_rockets"] = flyingObjects.size();
+	AudioSystem::Counters sound = audio.Stats();
+	report["sound"]["backend"] = audio.BackendName();
+	report["sound"]["played"] = sound.pool.played;
+	report["sound"]["coalesced"] = sound.pool.coalesced;
+	report["sound"]["dropped"] = sound.pool.dropped;
+	report["sound"]["stolen"] = sound.pool.stolen;
+	report["sound"]["queue_full"] = sound.queueFull;
+	report["sound"]["mean_latency_ms"] = sound.meanLatency * 1000.0;
+	report["sound"]["max_latency_ms"] = sound.maxLatency * 1000.0;
+	InputQueue::Counters input = inputEvents.Stats();
+	std::vector<float> inputMs;
+	for (size_t i = 0; i < inputEvents.Latencies().size(); i++) {
+		inputMs.push_back(inputEvents.Latencies()[i].ms);
+	}
+	std::sort(inputMs.begin(), inputMs.end());
+	auto inputPercentile = [&](double p) {
+		return inputMs.empty() ? 0.0f : inputMs[std::min(inputMs.size() - 1, static_cast<size_t>(p * inputMs.size()))];
+	};
+	report["input"]["events"] = input.events;
+	report["input"]["handled"] = input.handled;
+	report["input"]["latency_ms"]["mean"] = input.meanLatency * 1000.0;
+	report["input"]["latency_ms"]["p50"] = inputPercentile(0.50);
+	report["input"]["latency_ms"]["p99"] = inputPercentile(0.99);
+	report["input"]["latency_ms"]["max"] = input.maxLatency * 1000.0;
+
+	GameLog().Flush();
+	std::cout << report.dump(2) << std::endl;
+	std::ofstream file(stressConfig.outputPath);
+	if (!file) {
+		std::cout << "Failed to write " << stressConfig.outputPath << std::endl;
+		return -1;
+	}
+	file << report.dump(2) << std::endl;
+	return 0;
+}
+
+// Reads name=value options of --stress: items, lasers, rockets (per second), seconds and out
+bool parseStressArgs(int argc, char** argv, int first) {
+	for (int i = first; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg.compare(0, 2, "--") == 0) {
+			continue;
+		}
+		size_t split = arg.find('=');
+		std::string name = arg.substr(0, split);
+		std::string value = split == std::string::npos ? "" : arg.substr(split + 1);
+		try {
+			if (name == "items")
+				stressConfig.itemsPerSecond = std::stof(value);
+			else if (name == "lasers")
+				stressConfig.lasersPerSecond = std::stof(value);
+			else if (name == "rockets")
+				stressConfig.rocketsPerSecond = std::stof(value);
+			else if (name == "seconds")
+				stressConfig.duration = std::stod(value);
+			else if (name == "out" && !value.empty())
+				stressConfig.outputPath = value;
+			else
+				throw std::invalid_argument(name);
+		}
+		catch (const std::exception&) {
+			std::cout << "Unknown stress option " << arg << ", expected items=, lasers=, rockets=, seconds= or out=" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// Reads --fps=N (0 for no cap) and --no-vsync from anywhere on the command line
+bool parseFramePacingArgs(int argc, char** argv) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--no-vsync") {
+			vsyncEnabled = false;
+		}
+		else if (arg.compare(0, 6, "--fps=") == 0) {
+			try {
+				framePacer.SetTargetFps(std::stod(arg.substr(6)));
+			}
+			catch (const std::exception&) {
+				std::cout << "Invalid frame cap " << arg << std::endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Ends a frame: gameplay runs at the capped rate, everything else waits for input
+void waitForNextFrame(GLFWwindow* window) {
+	if (currentState != GameState::Game) {
+		glfwWaitEventsTimeout(MenuRedrawTimeout);
+	}
+	else if (!glfwGetWindowAttrib(window, GLFW_FOCUSED)) {
+		glfwWaitEventsTimeout(UnfocusedRedrawTimeout);
+	}
+	else {
+		framePacer.Wait();
+		glfwPollEvents();
+	}
+}
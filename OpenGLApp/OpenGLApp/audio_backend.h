@@ -0,0 +1,75 @@
+#ifndef AUDIO_BACKEND_H
+#define AUDIO_BACKEND_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Output driver behind the AudioSystem, only ever called from its audio thread.
+// Voices are slots 0..count-1 handed out by the caller, so starting and stopping
+// sounds needs no handles or allocations on either side.
+class AudioBackend {
+public:
+	virtual ~AudioBackend() {
+	}
+
+	virtual const char* Name() const = 0;
+
+	// Prepares the file for Play(), -1 if it cannot be played
+	virtual int LoadSound(const std::string& path) = 0;
+
+	// Stops every voice and makes room for count slots
+	virtual void SetVoiceCount(int count) = 0;
+
+	// Starts sound in the free slot voice, false if it could not start
+	virtual bool Play(int sound, int voice) = 0;
+
+	virtual bool IsFinished(int voice) = 0;
+
+	// Stops the voice if it still plays and frees its slot
+	virtual void Stop(int voice) = 0;
+};
+
+// Plays nothing, for machines without an audio device and headless runs.
+// Its voices last voiceSeconds, so voice caps and stealing behave as they
+// would with short sound effects on a real device.
+class NullAudioBackend : public AudioBackend {
+public:
+	explicit NullAudioBackend(double voiceSeconds = 0.25) : voiceLength(voiceSeconds) {
+	}
+
+	const char* Name() const override {
+		return "null";
+	}
+
+	int LoadSound(const std::string& path) override {
+		paths.push_back(path);
+		return static_cast<int>(paths.size()) - 1;
+	}
+
+	void SetVoiceCount(int count) override {
+		ends.assign(count, Clock::time_point());
+	}
+
+	bool Play(int, int voice) override {
+		ends[voice] = Clock::now() + std::chrono::duration_cast<Clock::duration>(voiceLength);
+		return true;
+	}
+
+	bool IsFinished(int voice) override {
+		return Clock::now() >= ends[voice];
+	}
+
+	void Stop(int voice) override {
+		ends[voice] = Clock::time_point();
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	std::chrono::duration<double> voiceLength;
+	std::vector<std::string> paths;
+	std::vector<Clock::time_point> ends;	// per voice
+};
+
+#endif
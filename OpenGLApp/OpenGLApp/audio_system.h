@@ -0,0 +1,179 @@
+#ifndef AUDIO_SYSTEM_H
+#define AUDIO_SYSTEM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_backend.h"
+#include "sound_pool.h"
+#include "spsc_queue.h"
+
+// One sound event as the audio thread handled it, kept while recording
+struct AudioEvent {
+	int sound;				// index in the pool, see SoundName()
+	SoundOutcome outcome;
+	double latency;			// seconds from Post() to the backend call
+};
+
+// Sound output on its own thread.
+// Post() only pushes a command into a lock-free single producer queue and
+// returns, so the thread that plays sounds (the simulation) never waits for
+// the backend or a lock. The audio thread drains the queue every couple of
+// milliseconds and runs the SoundPool on the backend. A full queue drops the event.
+// Open() a backend, add the sounds, then Start(). Holds the queue inline, so it
+// lives as a global rather than on the heap.
+class AudioSystem {
+public:
+	struct Counters {
+		SoundPool::Counters pool;
+		uint64_t queueFull;		// events lost because the audio thread fell behind
+		double meanLatency;		// seconds from Post() to the backend call
+		double maxLatency;
+	};
+
+	static const size_t QueueCapacity = 256;
+
+	AudioSystem() {
+	}
+
+	~AudioSystem() {
+		Close();
+	}
+
+	AudioSystem(const AudioSystem&) = delete;
+	AudioSystem& operator=(const AudioSystem&) = delete;
+
+	// Takes over backend, replacing the one opened before
+	void Open(AudioBackend* output, int voiceBudget = SoundPool::DefaultVoiceBudget) {
+		Close();
+		backend.reset(output);
+		pool.reset(new SoundPool(*backend, voiceBudget));
+	}
+
+	// Stops the audio thread and releases the backend; the recorded events stay
+	void Close() {
+		Stop();
+		pool.reset();
+		backend.reset();
+	}
+
+	bool AddSound(const char* name, const std::string& path, const SoundVoicePolicy& policy) {
+		return pool && !running && pool->Add(name, path, policy) >= 0;
+	}
+
+	// Keeps every event the audio thread handles until Stop(), e.g. for headless checks
+	void RecordEvents(bool record) {
+		if (!running) {
+			recording = record;
+		}
+	}
+
+	void Start() {
+		if (pool && !running) {
+			running = true;
+			thread = std::thread(&AudioSystem::run, this);
+		}
+	}
+
+	// Handles the events still queued and joins the audio thread
+	void Stop() {
+		if (running) {
+			running = false;
+			thread.join();
+		}
+	}
+
+	// Producer side, from one thread only. nullptr and sounds never added play nothing
+	void Post(const char* name) {
+		if (!name || !running.load(std::memory_order_relaxed)) {
+			return;
+		}
+		Command command = { pool->Find(name), Clock::now() };
+		if (!commands.TryPush(command)) {
+			queueFull.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	const char* BackendName() const {
+		return backend ? backend->Name() : "none";
+	}
+
+	const char* SoundName(int sound) const {
+		return pool && sound >= 0 ? pool->Name(sound) : "(unknown)";
+	}
+
+	int ActiveVoices() const {
+		return pool ? pool->ActiveVoices() : 0;
+	}
+
+	Counters Stats() const {
+		uint64_t handled = handledEvents.load(std::memory_order_relaxed);
+		return Counters{
+			pool ? pool->Stats() : SoundPool::Counters{ 0, 0, 0, 0 },
+			queueFull.load(std::memory_order_relaxed),
+			handled ? latencySumNs.load(std::memory_order_relaxed) * 1e-9 / handled : 0.0,
+			latencyMaxNs.load(std::memory_order_relaxed) * 1e-9 };
+	}
+
+	// The recorded events, complete once Stop() returned
+	const std::vector<AudioEvent>& Events() const {
+		return events;
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Command {
+		int sound;
+		Clock::time_point posted;
+	};
+
+	static std::chrono::milliseconds pollInterval() {
+		return std::chrono::milliseconds(2);
+	}
+
+	std::unique_ptr<AudioBackend> backend;
+	std::unique_ptr<SoundPool> pool;
+	SpscQueue<Command, QueueCapacity> commands;
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	bool recording = false;
+	std::vector<AudioEvent> events;
+	std::atomic<uint64_t> queueFull{ 0 };
+	std::atomic<uint64_t> handledEvents{ 0 };
+	std::atomic<uint64_t> latencySumNs{ 0 };
+	std::atomic<uint64_t> latencyMaxNs{ 0 };
+
+	void run() {
+		while (running.load(std::memory_order_acquire)) {
+			drain();
+			pool->Reap();
+			std::this_thread::sleep_for(pollInterval());
+		}
+		drain();
+	}
+
+	void drain() {
+		Command command;
+		while (commands.TryPop(command)) {
+			Clock::time_point now = Clock::now();
+			SoundOutcome outcome = pool->Play(command.sound, std::chrono::duration<double>(now.time_since_epoch()).count());
+			uint64_t latencyNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - command.posted).count());
+			handledEvents.fetch_add(1, std::memory_order_relaxed);
+			latencySumNs.fetch_add(latencyNs, std::memory_order_relaxed);
+			if (latencyNs > latencyMaxNs.load(std::memory_order_relaxed)) {
+				latencyMaxNs.store(latencyNs, std::memory_order_relaxed);
+			}
+			if (recording) {
+				events.push_back(AudioEvent{ command.sound, outcome, latencyNs * 1e-9 });
+			}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,19 @@
+#version 330 core
+// Baseline for the --bench-normals run: same as shader_light.vs but with the
+// normal matrix recomputed for every vertex
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec3 aNormal;
+
+out vec3 FragPos;
+out vec3 Normal;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,141 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+#include "shader_s.h"
+#include "gl_state.h"
+#include "stream_buffer.h"
+
+// Immediate-mode line renderer for debugging aids.
+// Primitives are only accumulated while the frame is built; Flush() moves all
+// of them to clip space on the CPU, streams them in one upload and draws them
+// with a single GL_LINES call using its own program.
+// World primitives go through the camera, Screen* primitives are in window
+// pixels with the origin at the bottom left, like renderText.
+class DebugDraw {
+public:
+	DebugDraw(const char* vertexPath, const char* fragmentPath, StreamBuffer& stream)
+		: shader(vertexPath, fragmentPath), stream(stream) {
+		glGenVertexArrays(1, &VAO);
+		GLState().BindVertexArray(VAO);
+		GLState().BindBuffer(GL_ARRAY_BUFFER, stream.Buffer());
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, color));
+		GLState().BindVertexArray(0);
+	}
+
+	~DebugDraw() {
+		GLState().DeleteVertexArray(VAO);
+	}
+
+	// The collision overlay is only submitted while enabled, so it costs nothing when off
+	bool IsEnabled() const {
+		return enabled;
+	}
+
+	void Toggle() {
+		enabled = !enabled;
+	}
+
+	void Line(const glm::vec3& a, const glm::vec3& b, const glm::vec3& color) {
+		worldPoints.push_back({ a, color });
+		worldPoints.push_back({ b, color });
+	}
+
+	// Axis aligned box given by its min and max corners
+	void Box(const glm::vec3& min, const glm::vec3& max, const glm::vec3& color) {
+		glm::vec3 c[8] = {
+			glm::vec3(min.x, min.y, min.z), glm::vec3(max.x, min.y, min.z),
+			glm::vec3(max.x, max.y, min.z), glm::vec3(min.x, max.y, min.z),
+			glm::vec3(min.x, min.y, max.z), glm::vec3(max.x, min.y, max.z),
+			glm::vec3(max.x, max.y, max.z), glm::vec3(min.x, max.y, max.z)
+		};
+		for (int i = 0; i < 4; i++) {
+			Line(c[i], c[(i + 1) % 4], color);			// back face
+			Line(c[i + 4], c[(i + 1) % 4 + 4], color);	// front face
+			Line(c[i], c[i + 4], color);				// edges in between
+		}
+	}
+
+	void Cross(const glm::vec3& center, float size, const glm::vec3& color) {
+		float h = size * 0.5f;
+		Line(center - glm::vec3(h, 0.0f, 0.0f), center + glm::vec3(h, 0.0f, 0.0f), color);
+		Line(center - glm::vec3(0.0f, h, 0.0f), center + glm::vec3(0.0f, h, 0.0f), color);
+		Line(center - glm::vec3(0.0f, 0.0f, h), center + glm::vec3(0.0f, 0.0f, h), color);
+	}
+
+	void ScreenLine(float x0, float y0, float x1, float y1, const glm::vec3& color) {
+		screenPoints.push_back({ glm::vec3(x0, y0, 0.0f), color });
+		screenPoints.push_back({ glm::vec3(x1, y1, 0.0f), color });
+	}
+
+	void ScreenRect(float left, float right, float top, float bottom, const glm::vec3& color) {
+		ScreenLine(left, top, right, top, color);
+		ScreenLine(right, top, right, bottom, color);
+		ScreenLine(right, bottom, left, bottom, color);
+		ScreenLine(left, bottom, left, top, color);
+	}
+
+	// Draws everything submitted since the last flush and clears the batch
+	void Flush(const glm::mat4& viewProjection, const glm::mat4& screenProjection) {
+		lastVertexCount = static_cast<unsigned int>(worldPoints.size() + screenPoints.size());
+		if (lastVertexCount == 0)
+			return;
+
+		StreamBuffer::Allocation lines = stream.Allocate(lastVertexCount * sizeof(LineVertex), sizeof(LineVertex));
+		if (lines.ptr) {
+			LineVertex* out = static_cast<LineVertex*>(lines.ptr);
+			for (size_t i = 0; i < worldPoints.size(); i++, out++) {
+				out->position = viewProjection * glm::vec4(worldPoints[i].position, 1.0f);
+				out->color = worldPoints[i].color;
+			}
+			for (size_t i = 0; i < screenPoints.size(); i++, out++) {
+				out->position = screenProjection * glm::vec4(screenPoints[i].position, 1.0f);
+				out->color = screenPoints[i].color;
+			}
+			stream.Commit();
+
+			shader.use();
+			GLState().SetDepthTest(false);
+			GLState().BindVertexArray(VAO);
+			glDrawArrays(GL_LINES, static_cast<GLint>(lines.offset / sizeof(LineVertex)), lastVertexCount);
+			GLState().SetDepthTest(true);
+		}
+
+		worldPoints.clear();
+		screenPoints.clear();
+	}
+
+	unsigned int LastVertexCount() const {
+		return lastVertexCount;
+	}
+
+private:
+	struct Point {
+		glm::vec3 position;
+		glm::vec3 color;
+	};
+
+	struct LineVertex {
+		glm::vec4 position;
+		glm::vec3 color;
+	};
+
+	Shader shader;
+	StreamBuffer& stream;
+	unsigned int VAO = 0;
+	bool enabled = false;
+	unsigned int lastVertexCount = 0;
+
+	std::vector<Point> worldPoints;
+	std::vector<Point> screenPoints;
+};
+
+#endif
@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec4 aPos; // already in clip space
+layout (location = 1) in vec3 aColor;
+
+out vec3 lineColor;
+
+void main()
+{
+    gl_Position = aPos;
+    lineColor = aColor;
+}
\ No newline at end of file
@@ -0,0 +1,756 @@
+#ifndef FONT_ATLAS_H
+#define FONT_ATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MODULE_H
+#include FT_GLYPH_H
+#include FT_CACHE_H
+#include FT_MULTIPLE_MASTERS_H
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gl_state.h"
+#include "utf8.h"
+
+// Letters. The metrics are in pixels of the font size the atlas was opened for,
+// whatever size the glyphs were rasterized at
+struct Character {
+	unsigned int TextureID; // ID handle of the texture array holding the glyph
+	glm::vec2 Size; // Size of glyph
+	glm::vec2 Bearing; // Offset from baseline to left/top of glyph
+	unsigned int Advance; // Horizontal offset to advance to next glyph (1/64 pixels)
+	glm::vec4 UV; // Left, top, right, bottom of the glyph in its page
+	int Page; // Layer of the texture array, -1 while the glyph is not resident
+};
+
+// What the atlas texels hold
+enum class GlyphRender {
+	Coverage,		// anti-aliased coverage, sharp only close to the font size
+	DistanceField	// signed distance to the outline, 0.5 on the edge; sharp at any scale
+};
+
+// Contents of a font file read once and shared by every atlas made from it, see FontFamily
+typedef std::shared_ptr<const std::vector<FT_Byte>> FontData;
+
+// A glyph rendered by FontAtlas::Rasterize(), waiting to be packed by FontAtlas::Build()
+struct RasterGlyph {
+	uint32_t Codepoint;
+	glm::vec2 Size;			// metrics as in Character
+	glm::vec2 Bearing;
+	unsigned int Advance;
+	int Width;				// bitmap in raster pixels, rows tightly packed
+	int Rows;
+	std::vector<unsigned char> Pixels;
+};
+
+// Glyphs of one font, rasterized the first time a code point is drawn.
+// FreeType's cache manager keeps the face and the parsed outlines within
+// MaxCacheBytes; the rasterized glyphs live in the pages of one red channel
+// texture array, so any text can still be drawn with one texture bound.
+// When every page is full, the least recently used page is cleared and its
+// glyphs are rasterized again on their next use. Generation() changes then,
+// telling retained vertices that their texture coordinates are outdated.
+// Each page keeps a small white block at its top left; quads sampling
+// SolidUV() come out as flat color with the text shaders in either render mode.
+//
+// The weight picks an instance of a variable font through its "wght" axis;
+// 0 keeps the font's default instance, static fonts ignore it.
+//
+// Save() bakes the pages and the metrics of every known glyph into one file.
+// Load() restores them with one read and one texture upload and leaves
+// FreeType alone until a glyph is missing from the file.
+//
+// Baked file layout (little endian, as written by the machine that baked it):
+//   "CFNT", version, render mode, pixel size, weight, raster size, spread, page size, page count,
+//   font file size and modification time, glyph count
+//   pages: packing cursor x, y, shelf height, glyph bytes, used rows, the used rows' pixels
+//   glyphs: code point, size, bearing, advance, uv, page
+class FontAtlas {
+public:
+	static const int PageSize = 256;
+	static const int PageCount = 4;
+	static const unsigned long MaxCacheBytes = 512 * 1024;
+
+	// Distance fields are rasterized smaller than the font size and scaled up by the shader
+	static const unsigned int DistanceFieldSize = 32;
+	static const int DistanceFieldSpread = 4;	// pixels of the raster size on both sides of the outline
+
+	FontAtlas() {
+	}
+
+	~FontAtlas() {
+		if (manager) {
+			FTC_Manager_Done(manager);
+		}
+		if (library) {
+			FT_Done_FreeType(library);
+		}
+		if (texture) {
+			GLState().DeleteTexture(texture);
+		}
+	}
+
+	FontAtlas(const FontAtlas&) = delete;
+	FontAtlas& operator=(const FontAtlas&) = delete;
+
+	// Size the glyphs of a pixelSize atlas are rasterized at
+	static unsigned int RasterSize(unsigned int pixelSize, GlyphRender render) {
+		return render == GlyphRender::DistanceField ? DistanceFieldSize : pixelSize;
+	}
+
+	// Sets what the atlas expects of a FreeType library, e.g. the distance field spread
+	static void ConfigureLibrary(FT_Library library) {
+		// Outline glyphs go through "sdf", embedded bitmaps through "bsdf"
+		FT_Int spread = DistanceFieldSpread;
+		FT_Property_Set(library, "sdf", "spread", &spread);
+		FT_Property_Set(library, "bsdf", "spread", &spread);
+	}
+
+	// Moves a variable face to weight on its "wght" axis, clamped to the axis range.
+	// 0 goes back to the default instance; faces without variations are left alone
+	static bool SetWeight(FT_Face face, float weight) {
+		if (!FT_HAS_MULTIPLE_MASTERS(face)) {
+			return true;
+		}
+		if (weight <= 0.0f) {
+			return !FT_Set_Var_Design_Coordinates(face, 0, nullptr);
+		}
+		FT_MM_Var* variations;
+		if (FT_Get_MM_Var(face, &variations)) {
+			return false;
+		}
+		std::vector<FT_Fixed> coordinates(variations->num_axis);
+		for (FT_UInt i = 0; i < variations->num_axis; i++) {
+			const FT_Var_Axis& axis = variations->axis[i];
+			coordinates[i] = axis.def;
+			if (axis.tag == FT_MAKE_TAG('w', 'g', 'h', 't')) {
+				FT_Fixed value = static_cast<FT_Fixed>(weight * 65536.0f);
+				coordinates[i] = std::min(std::max(value, axis.minimum), axis.maximum);
+			}
+		}
+		bool set = !FT_Set_Var_Design_Coordinates(face, variations->num_axis, coordinates.data());
+		FT_Done_MM_Var(face->glyph->library, variations);
+		return set;
+	}
+
+	// Renders the code points first..last of face the way an atlas opened for pixelSize
+	// would, without GL or any atlas state: safe on any thread that owns face and its
+	// library (set up with ConfigureLibrary), with its weight already set through SetWeight().
+	// Code points the face lacks are skipped
+	static void Rasterize(FT_Face face, unsigned int pixelSize, GlyphRender render, uint32_t first, uint32_t last, std::vector<RasterGlyph>& out) {
+		unsigned int rasterSize = RasterSize(pixelSize, render);
+		float toPixels = static_cast<float>(pixelSize) / rasterSize;
+		if (FT_Set_Pixel_Sizes(face, 0, rasterSize)) {
+			return;
+		}
+		for (uint32_t codepoint = first; codepoint <= last; codepoint++) {
+			FT_UInt index = FT_Get_Char_Index(face, codepoint);
+			if (index == 0 || FT_Load_Glyph(face, index, FT_LOAD_DEFAULT) ||
+				FT_Render_Glyph(face->glyph, render == GlyphRender::DistanceField ? FT_RENDER_MODE_SDF : FT_RENDER_MODE_NORMAL)) {
+				continue;
+			}
+			const FT_GlyphSlot slot = face->glyph;
+			const FT_Bitmap& bitmap = slot->bitmap;
+			RasterGlyph glyph;
+			glyph.Codepoint = codepoint;
+			glyph.Width = static_cast<int>(bitmap.width);
+			glyph.Rows = static_cast<int>(bitmap.rows);
+			glyph.Size = glm::vec2(glyph.Width, glyph.Rows) * toPixels;
+			glyph.Bearing = glm::vec2(slot->bitmap_left, slot->bitmap_top) * toPixels;
+			glyph.Advance = static_cast<unsigned int>(slot->advance.x * toPixels);
+			glyph.Pixels.resize(glyph.Width * glyph.Rows);
+			for (int row = 0; row < glyph.Rows; row++) {
+				memcpy(&glyph.Pixels[row * glyph.Width], bitmap.buffer + row * bitmap.pitch, glyph.Width);
+			}
+			out.push_back(std::move(glyph));
+		}
+	}
+
+	// Prepares the font at fontPath for text of pixelSize. Only checks that the face opens,
+	// no glyph is rasterized until it is drawn. With fontBytes, the face is made from those
+	// bytes instead of reading fontPath again
+	bool Open(const std::string& fontPath, unsigned int pixelSize, GlyphRender glyphRender = GlyphRender::Coverage, float fontWeight = 0.0f, FontData fontBytes = FontData()) {
+		if (texture) {
+			return false;
+		}
+		configure(fontPath, pixelSize, glyphRender, fontWeight, fontBytes);
+		if (!openFreeType()) {
+			return false;
+		}
+		for (int page = 0; page < PageCount; page++) {
+			clearPage(page);
+		}
+		createTexture();
+		return true;
+	}
+
+	// Restores an atlas baked by Save() for the same font file and settings. False if
+	// the file is missing, damaged or stale; nothing is changed then and Open() can follow
+	bool Load(const std::string& bakedPath, const std::string& fontPath, unsigned int pixelSize, GlyphRender glyphRender = GlyphRender::Coverage, float fontWeight = 0.0f, FontData fontBytes = FontData()) {
+		if (texture) {
+			return false;
+		}
+		uint64_t fontSize;
+		int64_t fontTime;
+		if (!fontStamp(fontPath, fontSize, fontTime)) {
+			return false;
+		}
+
+		std::ifstream file(bakedPath, std::ios::binary | std::ios::ate);
+		if (!file) {
+			return false;
+		}
+		std::vector<char> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		if (!file.read(data.data(), data.size())) {
+			return false;
+		}
+
+		configure(fontPath, pixelSize, glyphRender, fontWeight, fontBytes);
+		size_t at = 0;
+		char header[4] = {};
+		uint32_t version = 0, mode = 0, size = 0, raster = 0, pageSize = 0, pageCount = 0, glyphCount = 0;
+		int32_t spread = 0;
+		float bakedWeight = 0.0f;
+		uint64_t bakedFontSize = 0;
+		int64_t bakedFontTime = 0;
+		bool valid = take(data, at, header) && std::string(header, 4) == std::string(magic(), 4) &&
+			take(data, at, version) && version == Version &&
+			take(data, at, mode) && mode == static_cast<uint32_t>(render) &&
+			take(data, at, size) && size == pixelSize &&
+			take(data, at, bakedWeight) && bakedWeight == weight &&
+			take(data, at, raster) && raster == rasterSize &&
+			take(data, at, spread) && spread == DistanceFieldSpread &&
+			take(data, at, pageSize) && pageSize == PageSize &&
+			take(data, at, pageCount) && pageCount == PageCount &&
+			take(data, at, bakedFontSize) && bakedFontSize == fontSize &&
+			take(data, at, bakedFontTime) && bakedFontTime == fontTime &&
+			take(data, at, glyphCount);
+
+		for (int page = 0; valid && page < PageCount; page++) {
+			uint32_t usedRows = 0;
+			uint64_t glyphBytes = 0;
+			valid = take(data, at, pages[page].x) && take(data, at, pages[page].y) && take(data, at, pages[page].shelfHeight) &&
+				cursorValid(pages[page]) && take(data, at, glyphBytes) && take(data, at, usedRows) && usedRows <= PageSize &&
+				at + usedRows * PageSize <= data.size();
+			if (valid) {
+				pages[page].glyphBytes = static_cast<size_t>(glyphBytes);
+				memcpy(&pixels[page * PageSize * PageSize], &data[at], usedRows * PageSize);
+				at += usedRows * PageSize;
+			}
+		}
+		for (uint32_t i = 0; valid && i < glyphCount; i++) {
+			uint32_t codepoint = 0;
+			Character ch = Character{ 0, glm::vec2(0.0f), glm::vec2(0.0f), 0, glm::vec4(0.0f), -1 };
+			valid = take(data, at, codepoint) && take(data, at, ch.Size) && take(data, at, ch.Bearing) &&
+				take(data, at, ch.Advance) && take(data, at, ch.UV) && uvValid(ch.UV) &&
+				take(data, at, ch.Page) && ch.Page >= -1 && ch.Page < PageCount;
+			if (valid) {
+				glyphs[codepoint] = ch;
+				if (ch.Page >= 0) {
+					pages[ch.Page].glyphs.push_back(codepoint);
+				}
+			}
+		}
+		if (!valid) {
+			glyphs.clear();
+			configure(std::string(), 0, GlyphRender::Coverage, 0.0f, FontData());
+			return false;
+		}
+
+		createTexture();
+		for (std::unordered_map<uint32_t, Character>::iterator it = glyphs.begin(); it != glyphs.end(); ++it) {
+			it->second.TextureID = texture;
+		}
+		return true;
+	}
+
+	// Packs glyphs rendered by Rasterize() and uploads all pages at once. Like after Load(),
+	// FreeType only starts for glyphs that are still missing
+	bool Build(const std::string& fontPath, unsigned int pixelSize, GlyphRender glyphRender, const std::vector<RasterGlyph>& rendered, float fontWeight = 0.0f, FontData fontBytes = FontData()) {
+		if (texture) {
+			return false;
+		}
+		configure(fontPath, pixelSize, glyphRender, fontWeight, fontBytes);
+		for (int page = 0; page < PageCount; page++) {
+			clearPage(page);
+		}
+		for (size_t i = 0; i < rendered.size(); i++) {
+			const RasterGlyph& glyph = rendered[i];
+			if (glyphs.count(glyph.Codepoint)) {
+				continue;
+			}
+			Character& ch = glyphs[glyph.Codepoint];
+			ch = Character{ 0, glyph.Size, glyph.Bearing, glyph.Advance, glm::vec4(0.0f), -1 };
+			place(glyph.Codepoint, ch, glyph.Width, glyph.Rows, glyph.Pixels.data(), glyph.Width);
+		}
+		createTexture();
+		for (std::unordered_map<uint32_t, Character>::iterator it = glyphs.begin(); it != glyphs.end(); ++it) {
+			it->second.TextureID = texture;
+		}
+		modified = true;
+		return true;
+	}
+
+	// Bakes the resident pages and every known glyph into bakedPath
+	bool Save(const std::string& bakedPath) {
+		uint64_t fontSize;
+		int64_t fontTime;
+		if (!texture || !fontStamp(path, fontSize, fontTime)) {
+			return false;
+		}
+		std::ofstream file(bakedPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			return false;
+		}
+		uint32_t version = Version;
+		uint32_t mode = static_cast<uint32_t>(render);
+		uint32_t size = pixelSize;
+		int32_t spread = DistanceFieldSpread;
+		uint32_t pageSize = PageSize;
+		uint32_t pageCount = PageCount;
+		uint32_t glyphCount = static_cast<uint32_t>(glyphs.size());
+		file.write(magic(), 4);
+		write(file, version);
+		write(file, mode);
+		write(file, size);
+		write(file, weight);
+		write(file, rasterSize);
+		write(file, spread);
+		write(file, pageSize);
+		write(file, pageCount);
+		write(file, fontSize);
+		write(file, fontTime);
+		write(file, glyphCount);
+		for (int page = 0; page < PageCount; page++) {
+			// Only the rows the shelves reached hold anything
+			int reached = pages[page].y + pages[page].shelfHeight;
+			uint32_t usedRows = static_cast<uint32_t>(reached < PageSize ? reached : PageSize);
+			uint64_t glyphBytes = pages[page].glyphBytes;
+			write(file, pages[page].x);
+			write(file, pages[page].y);
+			write(file, pages[page].shelfHeight);
+			write(file, glyphBytes);
+			write(file, usedRows);
+			file.write(reinterpret_cast<const char*>(&pixels[page * PageSize * PageSize]), usedRows * PageSize);
+		}
+		for (std::unordered_map<uint32_t, Character>::const_iterator it = glyphs.begin(); it != glyphs.end(); ++it) {
+			write(file, it->first);
+			write(file, it->second.Size);
+			write(file, it->second.Bearing);
+			write(file, it->second.Advance);
+			write(file, it->second.UV);
+			write(file, it->second.Page);
+		}
+		if (!file) {
+			return false;
+		}
+		modified = false;
+		return true;
+	}
+
+	// True when glyphs were rasterized since the atlas was opened, loaded or saved
+	bool Modified() const {
+		return modified;
+	}
+
+	// True once FreeType was needed, i.e. some glyph was not baked
+	bool UsesFreeType() const {
+		return library != nullptr;
+	}
+
+	// Starts a new frame. Pages holding glyphs used since the previous call are only
+	// evicted when nothing else is left, so the text of one frame stays valid while it is drawn
+	void BeginFrame() {
+		frame++;
+	}
+
+	// The glyph of codepoint, rasterized into a page on first use. Code points
+	// the font lacks give its missing glyph box
+	const Character& Glyph(uint32_t codepoint) {
+		std::unordered_map<uint32_t, Character>::iterator found = glyphs.find(codepoint);
+		if (found == glyphs.end()) {
+			found = glyphs.insert(std::make_pair(codepoint, Character{ texture, glm::vec2(0.0f), glm::vec2(0.0f), 0, glm::vec4(0.0f), -1 })).first;
+			rasterize(codepoint, found->second);
+		}
+		else if (found->second.Page < 0 && found->second.Size.x > 0.0f) {
+			rasterize(codepoint, found->second);
+		}
+		if (found->second.Page >= 0) {
+			pages[found->second.Page].lastUse = frame;
+		}
+		return found->second;
+	}
+
+	GLuint Texture() const {
+		return texture;
+	}
+
+	GlyphRender Render() const {
+		return render;
+	}
+
+	float Weight() const {
+		return weight;
+	}
+
+	// Changes whenever a page was evicted
+	unsigned int Generation() const {
+		return generation;
+	}
+
+	// Texture coordinate inside the white block of the first page (u, v, layer)
+	glm::vec3 SolidUV() const {
+		return glm::vec3(SolidSize * 0.5f / PageSize, SolidSize * 0.5f / PageSize, 0.0f);
+	}
+
+	// Pen advance of the UTF-8 text at scale
+	float Advance(const std::string& text, float scale) {
+		float width = 0.0f;
+		for (size_t i = 0; i < text.size();) {
+			width += (Glyph(NextCodepoint(text, i)).Advance >> 6) * scale;
+		}
+		return width;
+	}
+
+	// Box covered by the glyphs of text drawn with its baseline starting at origin.
+	// Horizontally it spans the pen advance, so trailing spaces count
+	void Bounds(const std::string& text, const glm::vec2& origin, float scale, glm::vec2& min, glm::vec2& max) {
+		min = glm::vec2(origin.x, origin.y);
+		max = glm::vec2(origin.x + Advance(text, scale), origin.y);
+		for (size_t i = 0; i < text.size();) {
+			const Character& ch = Glyph(NextCodepoint(text, i));
+			if (ch.Size.y == 0.0f) {
+				continue;
+			}
+			min.y = std::min(min.y, origin.y - (ch.Size.y - ch.Bearing.y) * scale);
+			max.y = std::max(max.y, origin.y + ch.Bearing.y * scale);
+		}
+	}
+
+	// Memory of the page texture array
+	size_t TextureBytes() const {
+		return static_cast<size_t>(PageSize) * PageSize * PageCount;
+	}
+
+	// Pixels of the glyphs currently resident in the pages
+	size_t GlyphBytes() const {
+		size_t bytes = 0;
+		for (int page = 0; page < PageCount; page++) {
+			bytes += pages[page].glyphBytes;
+		}
+		return bytes;
+	}
+
+	size_t ResidentGlyphs() const {
+		size_t count = 0;
+		for (int page = 0; page < PageCount; page++) {
+			count += pages[page].glyphs.size();
+		}
+		return count;
+	}
+
+private:
+	static const int SolidSize = 2;
+	static const int Padding = 1;
+	// Page uploads bind the texture here through GLState(), the unit text is drawn with
+	static const unsigned int UploadUnit = 0;
+
+	// Shelf allocator of one layer: glyphs fill rows left to right, a row is as tall as its tallest glyph
+	struct Page {
+		int x = 0;
+		int y = 0;
+		int shelfHeight = 0;
+		uint64_t lastUse = 0;
+		size_t glyphBytes = 0;
+		std::vector<uint32_t> glyphs;	// code points packed here
+	};
+
+	static const uint32_t Version = 2;
+
+	static const char* magic() { return "CFNT"; }
+
+	std::string path;
+	GlyphRender render = GlyphRender::Coverage;
+	unsigned int pixelSize = 0;
+	float weight = 0.0f;
+	FontData fontData;	// empty: the face is read from path
+	unsigned int rasterSize = 0;
+	float toPixels = 1.0f;
+	FT_Library library = nullptr;
+	bool freeTypeFailed = false;
+	FTC_Manager manager = nullptr;
+	FTC_CMapCache cmapCache = nullptr;
+	FTC_ImageCache imageCache = nullptr;
+	GLuint texture = 0;
+	Page pages[PageCount];
+	std::vector<unsigned char> pixels;	// copy of all pages, layer after layer, for Save()
+	std::unordered_map<uint32_t, Character> glyphs;
+	uint64_t frame = 1;
+	unsigned int generation = 0;
+	bool modified = false;
+
+	void configure(const std::string& fontPath, unsigned int size, GlyphRender glyphRender, float fontWeight, const FontData& data) {
+		path = fontPath;
+		render = glyphRender;
+		pixelSize = size;
+		weight = fontWeight;
+		fontData = data;
+		rasterSize = RasterSize(size, glyphRender);
+		toPixels = rasterSize > 0 ? static_cast<float>(pixelSize) / rasterSize : 1.0f;
+		for (int page = 0; page < PageCount; page++) {
+			pages[page] = Page();
+		}
+		pixels.assign(static_cast<size_t>(PageSize) * PageSize * PageCount, 0);
+	}
+
+	// Starts FreeType and its cache manager on the first glyph that has to be rasterized
+	bool openFreeType() {
+		if (manager) {
+			return true;
+		}
+		if (freeTypeFailed) {
+			return false;
+		}
+		freeTypeFailed = true;
+		if (FT_Init_FreeType(&library)) {
+			library = nullptr;
+			return false;
+		}
+		ConfigureLibrary(library);
+		if (FTC_Manager_New(library, 1, 1, MaxCacheBytes, requestFace, this, &manager)) {
+			manager = nullptr;
+			return false;
+		}
+		FT_Face face;
+		if (FTC_CMapCache_New(manager, &cmapCache) || FTC_ImageCache_New(manager, &imageCache) ||
+			FTC_Manager_LookupFace(manager, faceId(), &face)) {
+			FTC_Manager_Done(manager);
+			manager = nullptr;
+			return false;
+		}
+		freeTypeFailed = false;
+		return true;
+	}
+
+	// Uploads every page at once
+	void createTexture() {
+		glGenTextures(1, &texture);
+		GLState().BindTexture(UploadUnit, texture, GL_TEXTURE_2D_ARRAY);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, PageSize, PageSize, PageCount, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+
+	// Size and modification time of the font file, a baked atlas is stale once they change
+	static bool fontStamp(const std::string& fontPath, uint64_t& size, int64_t& time) {
+		struct stat info;
+		if (stat(fontPath.c_str(), &info) != 0) {
+			return false;
+		}
+		size = static_cast<uint64_t>(info.st_size);
+		time = static_cast<int64_t>(info.st_mtime);
+		return true;
+	}
+
+	template <typename T>
+	static void write(std::ofstream& file, const T& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	// Reads the next value of a baked file already in memory
+	template <typename T>
+	static bool take(const std::vector<char>& data, size_t& at, T& value) {
+		if (at + sizeof(T) > data.size()) {
+			return false;
+		}
+		memcpy(&value, &data[at], sizeof(T));
+		at += sizeof(T);
+		return true;
+	}
+
+	// The cache manager opens the face through this when it needs it
+	static FT_Error requestFace(FTC_FaceID, FT_Library library, FT_Pointer requestData, FT_Face* face) {
+		const FontAtlas* atlas = static_cast<const FontAtlas*>(requestData);
+		FT_Error error = atlas->fontData ?
+			FT_New_Memory_Face(library, atlas->fontData->data(), static_cast<FT_Long>(atlas->fontData->size()), 0, face) :
+			FT_New_Face(library, atlas->path.c_str(), 0, face);
+		if (!error && !SetWeight(*face, atlas->weight)) {
+			FT_Done_Face(*face);
+			error = FT_Err_Invalid_Argument;
+		}
+		return error;
+	}
+
+	FTC_FaceID faceId() {
+		return static_cast<FTC_FaceID>(this);
+	}
+
+	// Fills in the metrics of ch and packs its bitmap into a page. Glyphs that fail to load
+	// or render keep what they got so far, at worst an empty glyph
+	void rasterize(uint32_t codepoint, Character& ch) {
+		if (!openFreeType()) {
+			return;
+		}
+		modified = true;
+		FT_UInt index = FTC_CMapCache_Lookup(cmapCache, faceId(), -1, codepoint);
+		FTC_ImageTypeRec type;
+		type.face_id = faceId();
+		type.width = 0;
+		type.height = rasterSize;
+		type.flags = FT_LOAD_DEFAULT;
+		FT_Glyph glyph;
+		if (FTC_ImageCache_Lookup(imageCache, &type, index, &glyph, nullptr)) {
+			return;
+		}
+		// Glyph advances are 16.16, the Character keeps 26.6
+		ch.Advance = static_cast<unsigned int>((glyph->advance.x >> 10) * toPixels);
+
+		// The cached outline stays untouched, the bitmap is a new glyph
+		FT_Glyph image = glyph;
+		if (FT_Glyph_To_Bitmap(&image, render == GlyphRender::DistanceField ? FT_RENDER_MODE_SDF : FT_RENDER_MODE_NORMAL, nullptr, 0)) {
+			return;
+		}
+		FT_BitmapGlyph bitmapGlyph = reinterpret_cast<FT_BitmapGlyph>(image);
+		const FT_Bitmap& bitmap = bitmapGlyph->bitmap;
+		int width = static_cast<int>(bitmap.width);
+		int rows = static_cast<int>(bitmap.rows);
+		ch.Size = glm::vec2(width, rows) * toPixels;
+		ch.Bearing = glm::vec2(bitmapGlyph->left, bitmapGlyph->top) * toPixels;
+		place(codepoint, ch, width, rows, bitmap.buffer, bitmap.pitch);
+		if (image != glyph) {
+			FT_Done_Glyph(image);
+		}
+	}
+
+	// Packs a width x rows bitmap into a page and makes ch point at it.
+	// Uploaded right away once the texture exists
+	void place(uint32_t codepoint, Character& ch, int width, int rows, const unsigned char* buffer, int pitch) {
+		glm::ivec2 origin;
+		int page = width > 0 && rows > 0 ? allocate(width, rows, origin) : -1;
+		if (page < 0) {
+			return;
+		}
+		unsigned char* target = &pixels[(page * PageSize + origin.y) * PageSize + origin.x];
+		for (int row = 0; row < rows; row++) {
+			memcpy(target + row * PageSize, buffer + row * pitch, width);
+		}
+		if (texture) {
+			// Straight from the page copy, its rows are PageSize apart
+			GLState().BindTexture(UploadUnit, texture, GL_TEXTURE_2D_ARRAY);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, PageSize);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, origin.x, origin.y, page, width, rows, 1, GL_RED, GL_UNSIGNED_BYTE, target);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		}
+
+		ch.Page = page;
+		ch.UV = glm::vec4(
+			static_cast<float>(origin.x) / PageSize,
+			static_cast<float>(origin.y) / PageSize,
+			static_cast<float>(origin.x + width) / PageSize,
+			static_cast<float>(origin.y + rows) / PageSize);
+		pages[page].glyphs.push_back(codepoint);
+		pages[page].glyphBytes += width * rows;
+	}
+
+	// Finds room for a width x rows bitmap, evicting the least recently used page
+	// if none is left. -1 if it cannot fit at all
+	int allocate(int width, int rows, glm::ivec2& origin) {
+		if (width > PageSize || rows > PageSize) {
+			return -1;
+		}
+		for (int page = 0; page < PageCount; page++) {
+			if (fit(pages[page], width, rows, origin)) {
+				return page;
+			}
+		}
+
+		int victim = 0;
+		for (int page = 1; page < PageCount; page++) {
+			if (pages[page].lastUse < pages[victim].lastUse) {
+				victim = page;
+			}
+		}
+		clearPage(victim);
+		generation++;
+		return fit(pages[victim], width, rows, origin) ? victim : -1;
+	}
+
+	static bool fit(Page& page, int width, int rows, glm::ivec2& origin) {
+		int x = page.x;
+		int y = page.y;
+		int shelfHeight = page.shelfHeight;
+		if (x + width > PageSize) {
+			x = 0;
+			y += shelfHeight + Padding;
+			shelfHeight = 0;
+		}
+		if (y + rows > PageSize) {
+			return false;
+		}
+		origin = glm::ivec2(x, y);
+		page.x = x + width + Padding;
+		page.y = y;
+		page.shelfHeight = std::max(shelfHeight, rows);
+		return true;
+	}
+
+	// Whether a cursor read by Load() is one fit() can leave behind. x may end one
+	// Padding past the page; anything outside would let fit() place glyphs off the page
+	static bool cursorValid(const Page& page) {
+		return page.x >= 0 && page.x <= PageSize + Padding && page.y >= 0 && page.y <= PageSize &&
+			page.shelfHeight >= 0 && page.shelfHeight <= PageSize;
+	}
+
+	static bool uvValid(const glm::vec4& uv) {
+		for (int i = 0; i < 4; i++) {
+			if (!(uv[i] >= 0.0f && uv[i] <= 1.0f)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Empties a page: its glyphs become non-resident, only the solid block is left.
+	// Uploaded right away once the texture exists
+	void clearPage(int index) {
+		Page& page = pages[index];
+		for (size_t i = 0; i < page.glyphs.size(); i++) {
+			Character& ch = glyphs[page.glyphs[i]];
+			ch.Page = -1;
+			ch.UV = glm::vec4(0.0f);
+		}
+		page = Page();
+		page.x = SolidSize + Padding;
+		page.shelfHeight = SolidSize;
+
+		unsigned char* layer = &pixels[index * PageSize * PageSize];
+		memset(layer, 0, PageSize * PageSize);
+		for (int row = 0; row < SolidSize; row++) {
+			memset(&layer[row * PageSize], 255, SolidSize);
+		}
+		if (texture) {
+			GLState().BindTexture(UploadUnit, texture, GL_TEXTURE_2D_ARRAY);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, index, PageSize, PageSize, 1, GL_RED, GL_UNSIGNED_BYTE, layer);
+		}
+	}
+};
+
+#endif
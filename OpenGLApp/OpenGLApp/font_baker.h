@@ -0,0 +1,116 @@
+#ifndef FONT_BAKER_H
+#define FONT_BAKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "font_atlas.h"
+#include "job_system.h"
+
+// One atlas to bake: a font file at one size, render mode and weight (see FontAtlas),
+// and the code points to rasterize
+struct FontBakeConfig {
+	std::string path;
+	unsigned int pixelSize;
+	GlyphRender render;
+	float weight;
+	uint32_t first;
+	uint32_t last;
+};
+
+// Where the time of one configuration went
+struct FontBakeTiming {
+	double rasterMs;	// rendering its ranges, summed over the workers that took them
+	double buildMs;		// packing and the one texture upload on the calling thread
+	size_t glyphs;
+};
+
+const uint32_t FontBakeRange = 16;	// code points per job
+
+// Builds atlases[i] from configs[i] for every configuration at once. The atlases must be
+// new, and the calling thread must own the GL context.
+// The code points are cut into ranges of FontBakeRange; one lane per worker (plus the
+// caller) takes ranges off a shared counter and renders them with its own FT_Library and
+// one FT_Face per font file, since FreeType objects must not be shared between threads.
+// The weights of a variable font all come from that one face.
+// Only then are the atlases packed and uploaded, each with one glTexImage3D.
+// Returns the wall time of the whole bake in milliseconds
+inline double BakeFontAtlases(JobSystem& jobs, const std::vector<FontBakeConfig>& configs, FontAtlas* const* atlases, std::vector<FontBakeTiming>& timings) {
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+
+	struct Range {
+		size_t config;
+		uint32_t first;
+		uint32_t last;
+	};
+	std::vector<Range> ranges;
+	for (size_t i = 0; i < configs.size(); i++) {
+		for (uint32_t first = configs[i].first; first <= configs[i].last; first += FontBakeRange) {
+			uint32_t last = configs[i].last - first < FontBakeRange ? configs[i].last : first + FontBakeRange - 1;
+			ranges.push_back(Range{ i, first, last });
+			if (last == configs[i].last) {
+				break;
+			}
+		}
+	}
+
+	std::vector<std::vector<RasterGlyph>> rendered(ranges.size());
+	std::vector<double> rangeMs(ranges.size(), 0.0);
+	std::atomic<size_t> nextRange(0);
+	jobs.ParallelFor(jobs.WorkerCount() + 1, 1, [&](size_t, size_t) {
+		FT_Library library;
+		if (FT_Init_FreeType(&library)) {
+			return;
+		}
+		FontAtlas::ConfigureLibrary(library);
+		std::map<std::string, FT_Face> faces;
+		for (size_t r = nextRange.fetch_add(1); r < ranges.size(); r = nextRange.fetch_add(1)) {
+			Clock::time_point rangeStart = Clock::now();
+			const FontBakeConfig& config = configs[ranges[r].config];
+			std::map<std::string, FT_Face>::iterator face = faces.find(config.path);
+			if (face == faces.end()) {
+				FT_Face opened = nullptr;
+				if (FT_New_Face(library, config.path.c_str(), 0, &opened)) {
+					opened = nullptr;
+				}
+				face = faces.insert(std::make_pair(config.path, opened)).first;
+			}
+			if (face->second && FontAtlas::SetWeight(face->second, config.weight)) {
+				FontAtlas::Rasterize(face->second, config.pixelSize, config.render, ranges[r].first, ranges[r].last, rendered[r]);
+			}
+			rangeMs[r] = std::chrono::duration<double, std::milli>(Clock::now() - rangeStart).count();
+		}
+		for (std::map<std::string, FT_Face>::iterator it = faces.begin(); it != faces.end(); ++it) {
+			if (it->second) {
+				FT_Done_Face(it->second);
+			}
+		}
+		FT_Done_FreeType(library);
+	});
+
+	// Ranges of a configuration are consecutive, so its glyphs come out in code point order
+	timings.assign(configs.size(), FontBakeTiming{ 0.0, 0.0, 0 });
+	std::vector<RasterGlyph> glyphs;
+	size_t r = 0;
+	for (size_t i = 0; i < configs.size(); i++) {
+		glyphs.clear();
+		for (; r < ranges.size() && ranges[r].config == i; r++) {
+			timings[i].rasterMs += rangeMs[r];
+			for (size_t g = 0; g < rendered[r].size(); g++) {
+				glyphs.push_back(std::move(rendered[r][g]));
+			}
+		}
+		Clock::time_point buildStart = Clock::now();
+		atlases[i]->Build(configs[i].path, configs[i].pixelSize, configs[i].render, glyphs, configs[i].weight);
+		timings[i].buildMs = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+		timings[i].glyphs = glyphs.size();
+	}
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+#endif
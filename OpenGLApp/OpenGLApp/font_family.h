@@ -0,0 +1,103 @@
+#ifndef FONT_FAMILY_H
+#define FONT_FAMILY_H
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "font_atlas.h"
+
+// Every weight and size of one font file.
+// The file is read once in Open(); each atlas made by Instance() builds its face
+// from those bytes, and with a variable font such as Antonio-VariableFont_wght
+// the weight is set on the face's "wght" axis instead of loading a static file
+// per weight. Instances are cached per weight, size and render mode and live as
+// long as the family.
+class FontFamily {
+public:
+	FontFamily() {
+	}
+
+	FontFamily(const FontFamily&) = delete;
+	FontFamily& operator=(const FontFamily&) = delete;
+
+	bool Open(const std::string& fontPath) {
+		std::ifstream file(fontPath, std::ios::binary | std::ios::ate);
+		if (!file) {
+			return false;
+		}
+		std::shared_ptr<std::vector<FT_Byte>> bytes(new std::vector<FT_Byte>(static_cast<size_t>(file.tellg())));
+		file.seekg(0);
+		if (!file.read(reinterpret_cast<char*>(bytes->data()), bytes->size())) {
+			return false;
+		}
+		path = fontPath;
+		data = bytes;
+		return true;
+	}
+
+	// The atlas for weight (0: the font's default) at pixelSize, created on first request.
+	// With bakedPath it is loaded from there; when that file is missing or stale the
+	// printable ASCII glyphs are rasterized and baked again. nullptr if the font fails
+	FontAtlas* Instance(float weight, unsigned int pixelSize, GlyphRender render, const std::string& bakedPath = std::string()) {
+		Key key(weight, pixelSize, render);
+		std::map<Key, Entry>::iterator found = instances.find(key);
+		if (found != instances.end()) {
+			return found->second.atlas.get();
+		}
+		if (!data) {
+			return nullptr;
+		}
+
+		std::unique_ptr<FontAtlas> atlas(new FontAtlas());
+		if (bakedPath.empty() || !atlas->Load(bakedPath, path, pixelSize, render, weight, data)) {
+			if (!atlas->Open(path, pixelSize, render, weight, data)) {
+				return nullptr;
+			}
+			if (!bakedPath.empty()) {
+				for (uint32_t c = 32; c < 127; c++) {
+					atlas->Glyph(c);
+				}
+				atlas->Save(bakedPath);
+			}
+		}
+		Entry& entry = instances[key];
+		entry.atlas = std::move(atlas);
+		entry.bakedPath = bakedPath;
+		return entry.atlas.get();
+	}
+
+	// Bakes again the instances that rasterized glyphs since they were loaded or baked
+	void SaveBaked() {
+		for (std::map<Key, Entry>::iterator it = instances.begin(); it != instances.end(); ++it) {
+			if (!it->second.bakedPath.empty() && it->second.atlas->Modified()) {
+				it->second.atlas->Save(it->second.bakedPath);
+			}
+		}
+	}
+
+	size_t InstanceCount() const {
+		return instances.size();
+	}
+
+	size_t FileBytes() const {
+		return data ? data->size() : 0;
+	}
+
+private:
+	typedef std::tuple<float, unsigned int, GlyphRender> Key;
+
+	struct Entry {
+		std::unique_ptr<FontAtlas> atlas;
+		std::string bakedPath;
+	};
+
+	std::string path;
+	FontData data;
+	std::map<Key, Entry> instances;
+};
+
+#endif
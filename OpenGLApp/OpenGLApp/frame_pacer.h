@@ -0,0 +1,63 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+#include <thread>
+
+// Caps the frame rate without relying on vsync.
+// Sleeping alone overshoots by the scheduler granularity, spinning alone burns a
+// core, so Wait() sleeps until shortly before the deadline and spins the rest.
+// How early it wakes up follows the oversleep it actually observed.
+class FramePacer {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	// 0 disables the cap
+	void SetTargetFps(double fps) {
+		interval = fps > 0.0 ? std::chrono::duration<double>(1.0 / fps) : std::chrono::duration<double>(0.0);
+		deadline = Clock::time_point();
+	}
+
+	double TargetFps() const {
+		return interval.count() > 0.0 ? 1.0 / interval.count() : 0.0;
+	}
+
+	// Blocks until the next frame is due. Call once per frame, right after the swap
+	void Wait() {
+		if (interval.count() <= 0.0) {
+			return;
+		}
+
+		Clock::time_point now = Clock::now();
+		// First frame, or so far behind that catching up would only cause a burst of frames
+		if (deadline == Clock::time_point() || now - deadline > 4 * interval) {
+			deadline = now;
+		}
+		deadline += std::chrono::duration_cast<Clock::duration>(interval);
+
+		Clock::time_point wake = deadline - std::chrono::duration_cast<Clock::duration>(spinMargin);
+		if (now < wake) {
+			std::this_thread::sleep_until(wake);
+			std::chrono::duration<double> oversleep = Clock::now() - wake;
+			// Grow at once after a late wake up, shrink slowly when the scheduler behaves
+			if (oversleep > spinMargin)
+				spinMargin = oversleep < maxSpinMargin() ? oversleep : maxSpinMargin();
+			else
+				spinMargin = spinMargin * 0.95 + oversleep * 0.05;
+		}
+		while (Clock::now() < deadline) {
+			std::this_thread::yield();
+		}
+	}
+
+private:
+	std::chrono::duration<double> interval = std::chrono::duration<double>(0.0);
+	std::chrono::duration<double> spinMargin = std::chrono::duration<double>(0.002);
+	Clock::time_point deadline;
+
+	static std::chrono::duration<double> maxSpinMargin() {
+		return std::chrono::duration<double>(0.02);
+	}
+};
+
+#endif
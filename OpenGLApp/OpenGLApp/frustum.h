@@ -0,0 +1,46 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// View frustum as six planes pointing inwards, extracted from projection * view
+// (Gribb/Hartmann). A point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+class Frustum {
+public:
+	Frustum() {
+		Update(glm::mat4(1.0f));
+	}
+
+	explicit Frustum(const glm::mat4& viewProjection) {
+		Update(viewProjection);
+	}
+
+	void Update(const glm::mat4& m) {
+		// glm is column major: m[column][row]
+		for (int i = 0; i < 3; i++) {
+			planes[i * 2]     = row(m, 3) + row(m, i);	// left, bottom, near
+			planes[i * 2 + 1] = row(m, 3) - row(m, i);	// right, top, far
+		}
+		for (int i = 0; i < 6; i++) {
+			float length = glm::length(glm::vec3(planes[i]));
+			planes[i] /= length;
+		}
+	}
+
+	bool IntersectsSphere(const glm::vec3& center, float radius) const {
+		for (int i = 0; i < 6; i++) {
+			if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+				return false;
+		}
+		return true;
+	}
+
+private:
+	glm::vec4 planes[6];
+
+	static glm::vec4 row(const glm::mat4& m, int r) {
+		return glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+	}
+};
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// Thin cache in front of the glad calls issued every frame.
+// Each setter remembers the last value sent to the driver and skips the call
+// when it would not change anything. Code that talks to GL directly must call
+// Invalidate() afterwards so the cache does not trust stale values.
+class GLStateCache {
+public:
+	static const unsigned int MaxTextureUnits = 16;
+
+	struct Counters {
+		unsigned int issued = 0;
+		unsigned int skipped = 0;
+	};
+
+	GLStateCache() {
+		Invalidate();
+	}
+
+	void Invalidate() {
+		program = Unknown;
+		vertexArray = Unknown;
+		arrayBuffer = Unknown;
+		elementBuffer = Unknown;
+		activeUnit = Unknown;
+		for (unsigned int i = 0; i < MaxTextureUnits; i++)
+			textures[i] = Unknown;
+		blend = -1;
+		depthTest = -1;
+		blendSrc = Unknown;
+		blendDst = Unknown;
+	}
+
+	void UseProgram(GLuint id) {
+		if (!changed(program, id))
+			return;
+		glUseProgram(id);
+	}
+
+	void BindVertexArray(GLuint id) {
+		if (!changed(vertexArray, id))
+			return;
+		glBindVertexArray(id);
+		// The element buffer binding is part of the VAO state
+		elementBuffer = Unknown;
+	}
+
+	void BindBuffer(GLenum target, GLuint id) {
+		if (target == GL_ARRAY_BUFFER) {
+			if (!changed(arrayBuffer, id))
+				return;
+		}
+		else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+			if (!changed(elementBuffer, id))
+				return;
+		}
+		else {
+			current.issued++;
+		}
+		glBindBuffer(target, id);
+	}
+
+	void ActiveTexture(unsigned int unit) {
+		if (!changed(activeUnit, unit))
+			return;
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	// Binds a texture on the given unit, switching the active unit only when needed.
+	// Texture names are unique across targets, so one cached name per unit is enough
+	void BindTexture(unsigned int unit, GLuint id, GLenum target = GL_TEXTURE_2D) {
+		if (unit >= MaxTextureUnits) {
+			current.issued += 2;
+			glActiveTexture(GL_TEXTURE0 + unit);
+			glBindTexture(target, id);
+			activeUnit = unit;
+			return;
+		}
+		if (!changed(textures[unit], id))
+			return;
+		ActiveTexture(unit);
+		glBindTexture(target, id);
+	}
+
+	void SetBlend(bool enabled) {
+		if (!changed(blend, enabled ? 1 : 0))
+			return;
+		if (enabled)
+			glEnable(GL_BLEND);
+		else
+			glDisable(GL_BLEND);
+	}
+
+	void BlendFunc(GLenum src, GLenum dst) {
+		if (blendSrc == src && blendDst == dst) {
+			current.skipped++;
+			return;
+		}
+		current.issued++;
+		blendSrc = src;
+		blendDst = dst;
+		glBlendFunc(src, dst);
+	}
+
+	void SetDepthTest(bool enabled) {
+		if (!changed(depthTest, enabled ? 1 : 0))
+			return;
+		if (enabled)
+			glEnable(GL_DEPTH_TEST);
+		else
+			glDisable(GL_DEPTH_TEST);
+	}
+
+	// Deleting a bound object silently rebinds 0, so keep the cache in sync
+	void DeleteVertexArray(GLuint id) {
+		if (vertexArray == id) {
+			vertexArray = 0;
+			elementBuffer = Unknown;
+		}
+		glDeleteVertexArrays(1, &id);
+	}
+
+	void DeleteBuffer(GLuint id) {
+		if (arrayBuffer == id)
+			arrayBuffer = 0;
+		if (elementBuffer == id)
+			elementBuffer = 0;
+		glDeleteBuffers(1, &id);
+	}
+
+	void DeleteTexture(GLuint id) {
+		for (unsigned int i = 0; i < MaxTextureUnits; i++) {
+			if (textures[i] == id)
+				textures[i] = 0;
+		}
+		glDeleteTextures(1, &id);
+	}
+
+	GLuint BoundVertexArray() const {
+		return vertexArray;
+	}
+
+	// Starts counting a new frame, keeping the totals of the previous one
+	void BeginFrame() {
+		last = current;
+		current = Counters();
+	}
+
+	const Counters& LastFrame() const {
+		return last;
+	}
+
+private:
+	static const GLuint Unknown = 0xFFFFFFFFu;
+
+	GLuint program;
+	GLuint vertexArray;
+	GLuint arrayBuffer;
+	GLuint elementBuffer;
+	GLuint activeUnit;
+	GLuint textures[MaxTextureUnits];
+	int blend;
+	int depthTest;
+	GLenum blendSrc;
+	GLenum blendDst;
+
+	Counters current;
+	Counters last;
+
+	template <typename T>
+	bool changed(T& cached, T value) {
+		if (cached == value) {
+			current.skipped++;
+			return false;
+		}
+		current.issued++;
+		cached = value;
+		return true;
+	}
+};
+
+// Single cache shared by the whole application (there is only one GL context)
+inline GLStateCache& GLState() {
+	static GLStateCache cache;
+	return cache;
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// One key or mouse button change as the GLFW callback reported it
+struct InputEvent {
+	enum Device : uint8_t { Key, Mouse };
+
+	Device device;
+	bool pressed;		// false for a release
+	bool handled;		// a frame acted on it, its latency is taken at the next Presented()
+	int code;			// GLFW key or mouse button
+	double x, y;		// cursor in window coordinates, mouse buttons only
+	double time;		// glfwGetTime() when the callback ran
+};
+
+// Input-to-present latency of one handled event
+struct InputLatency {
+	InputEvent::Device device;
+	int code;
+	float ms;
+};
+
+// Key and mouse button edges of the window.
+// The GLFW callbacks Push() every change while events are polled and BeginFrame()
+// hands the frame what arrived since the last one. Pressed() and Clicked() take the
+// press edges, so holding a key or a button acts once, and Down() follows the held
+// state the events add up to. Events a frame acted on are stamped, Presented()
+// after the swap records how long each took from the callback to the screen.
+// Events a frame ignored are dropped at the next BeginFrame(). Main thread only.
+class InputQueue {
+public:
+	static const size_t MaxLatencies = 4096;	// latencies kept for percentiles, the oldest are overwritten
+
+	struct Counters {
+		uint64_t events;		// presses and releases seen
+		uint64_t handled;		// of those, acted on by a frame
+		double meanLatency;		// seconds from the callback to the end of the swap
+		double maxLatency;
+	};
+
+	void Push(InputEvent::Device device, int code, bool pressed, double x, double y, double time) {
+		pending.push_back(InputEvent{ device, pressed, false, code, x, y, time });
+	}
+
+	void BeginFrame() {
+		frame.swap(pending);
+		pending.clear();
+		for (size_t i = 0; i < frame.size(); i++) {
+			const InputEvent& event = frame[i];
+			if (event.device != InputEvent::Key) {
+				continue;
+			}
+			std::vector<int>::iterator held = std::find(heldKeys.begin(), heldKeys.end(), event.code);
+			if (event.pressed && held == heldKeys.end()) {
+				heldKeys.push_back(event.code);
+			}
+			else if (!event.pressed && held != heldKeys.end()) {
+				heldKeys.erase(held);
+			}
+		}
+		eventCount += frame.size();
+	}
+
+	// True if key went down this frame, once
+	bool Pressed(int key) {
+		return take(InputEvent::Key, key) != nullptr;
+	}
+
+	// True if button went down this frame, once; x and y get the cursor of that press
+	bool Clicked(int button, double& x, double& y) {
+		const InputEvent* press = take(InputEvent::Mouse, button);
+		if (!press) {
+			return false;
+		}
+		x = press->x;
+		y = press->y;
+		return true;
+	}
+
+	// Whether key is held after this frame's events; its presses count as handled
+	bool Down(int key) {
+		take(InputEvent::Key, key);
+		return std::find(heldKeys.begin(), heldKeys.end(), key) != heldKeys.end();
+	}
+
+	// Call right after the swap that shows the frame's response. now in glfwGetTime() seconds
+	void Presented(double now) {
+		for (size_t i = 0; i < frame.size(); i++) {
+			InputEvent& event = frame[i];
+			if (!event.handled) {
+				continue;
+			}
+			double latency = now - event.time;
+			InputLatency sample{ event.device, event.code, static_cast<float>(latency * 1000.0) };
+			if (latencies.size() < MaxLatencies) {
+				latencies.push_back(sample);
+			}
+			else {
+				latencies[handledCount % MaxLatencies] = sample;
+			}
+			handledCount++;
+			latencySum += latency;
+			latencyMax = std::max(latencyMax, latency);
+		}
+	}
+
+	Counters Stats() const {
+		return Counters{ eventCount, handledCount, handledCount ? latencySum / handledCount : 0.0, latencyMax };
+	}
+
+	// The last MaxLatencies handled events, not in order once the oldest were overwritten
+	const std::vector<InputLatency>& Latencies() const {
+		return latencies;
+	}
+
+private:
+	std::vector<InputEvent> pending;
+	std::vector<InputEvent> frame;
+	std::vector<int> heldKeys;
+	std::vector<InputLatency> latencies;
+	uint64_t eventCount = 0;
+	uint64_t handledCount = 0;
+	double latencySum = 0.0;
+	double latencyMax = 0.0;
+
+	// Stamps the presses of code this frame has not acted on yet, the first one or nullptr
+	const InputEvent* take(InputEvent::Device device, int code) {
+		const InputEvent* first = nullptr;
+		for (size_t i = 0; i < frame.size(); i++) {
+			InputEvent& event = frame[i];
+			if (event.device == device && event.code == code && event.pressed && !event.handled) {
+				event.handled = true;
+				if (!first) {
+					first = &event;
+				}
+			}
+		}
+		return first;
+	}
+};
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef INPUT_RECORDING_H
+#define INPUT_RECORDING_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Seed, difficulty and the input of every simulation tick of one game.
+// With the same seed and the same ticks the game rules replay exactly, so a
+// recording reproduces a session without the window, the clock or the player.
+//
+// File layout (little endian, as written by the machine that recorded it):
+//   "CIRC", version, seed, difficulty, tick count, run count
+//   runs: flags (1 byte), repeat count (4 bytes), mouse x and y (floats, only with Click)
+// Ticks without a click that repeat the previous flags are stored as one run.
+class InputRecording {
+public:
+	enum Flags : uint8_t {
+		Left = 1,
+		Right = 2,
+		Fire = 4,
+		Click = 8
+	};
+
+	struct Tick {
+		uint8_t flags = 0;
+		float mouseX = 0.0f;
+		float mouseY = 0.0f;
+	};
+
+	// Starts a new recording, dropping the old ticks
+	void Begin(uint32_t gameSeed, int gameDifficulty) {
+		seed = gameSeed;
+		difficulty = gameDifficulty;
+		runs.clear();
+		tickCount = 0;
+		Rewind();
+	}
+
+	void Append(const Tick& tick) {
+		if (!runs.empty() && !(tick.flags & Click) && runs.back().tick.flags == tick.flags) {
+			runs.back().count++;
+		}
+		else {
+			Run run;
+			run.tick = tick;
+			run.count = 1;
+			runs.push_back(run);
+		}
+		tickCount++;
+	}
+
+	// Playback: hands out the recorded ticks in order, false once they ran out
+	bool Next(Tick& tick) {
+		if (cursorRun >= runs.size()) {
+			return false;
+		}
+		tick = runs[cursorRun].tick;
+		if (++cursorTick >= runs[cursorRun].count) {
+			cursorRun++;
+			cursorTick = 0;
+		}
+		return true;
+	}
+
+	void Rewind() {
+		cursorRun = 0;
+		cursorTick = 0;
+	}
+
+	uint32_t Seed() const { return seed; }
+	int Difficulty() const { return difficulty; }
+	uint64_t TickCount() const { return tickCount; }
+
+	bool Save(const std::string& path) const {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			return false;
+		}
+		uint32_t version = Version;
+		uint32_t runCount = static_cast<uint32_t>(runs.size());
+		file.write(magic(), 4);
+		write(file, version);
+		write(file, seed);
+		write(file, difficulty);
+		write(file, tickCount);
+		write(file, runCount);
+		for (size_t i = 0; i < runs.size(); i++) {
+			write(file, runs[i].tick.flags);
+			write(file, runs[i].count);
+			if (runs[i].tick.flags & Click) {
+				write(file, runs[i].tick.mouseX);
+				write(file, runs[i].tick.mouseY);
+			}
+		}
+		return static_cast<bool>(file);
+	}
+
+	// False for a missing, truncated or inconsistent file, or a difficulty outside
+	// [minDifficulty, maxDifficulty]; the recording is left empty then
+	bool Load(const std::string& path, int minDifficulty, int maxDifficulty) {
+		if (!load(path, minDifficulty, maxDifficulty)) {
+			Begin(0, 0);
+			return false;
+		}
+		Rewind();
+		return true;
+	}
+
+private:
+	static const uint32_t Version = 1;
+
+	static const char* magic() { return "CIRC"; }
+
+	// Smallest run in the file: flags and repeat count without a click position
+	static const size_t MinRunBytes = sizeof(uint8_t) + sizeof(uint32_t);
+
+	struct Run {
+		Tick tick;
+		uint32_t count = 0;
+	};
+
+	uint32_t seed = 0;
+	int32_t difficulty = 0;
+	uint64_t tickCount = 0;
+	std::vector<Run> runs;
+	size_t cursorRun = 0;
+	uint32_t cursorTick = 0;
+
+	bool load(const std::string& path, int minDifficulty, int maxDifficulty) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file) {
+			return false;
+		}
+		std::streamoff fileSize = file.tellg();
+		file.seekg(0);
+		char header[4];
+		uint32_t version = 0;
+		uint32_t runCount = 0;
+		if (!file.read(header, 4) || std::string(header, 4) != std::string(magic(), 4) || !read(file, version) || version != Version) {
+			return false;
+		}
+		if (!read(file, seed) || !read(file, difficulty) || !read(file, tickCount) || !read(file, runCount)) {
+			return false;
+		}
+		// The runs must fit in what is left, so a damaged count cannot reserve gigabytes
+		std::streamoff remaining = fileSize - file.tellg();
+		if (difficulty < minDifficulty || difficulty > maxDifficulty || remaining < 0 ||
+			runCount > static_cast<uint64_t>(remaining) / MinRunBytes) {
+			return false;
+		}
+
+		runs.clear();
+		runs.reserve(runCount);
+		uint64_t ticks = 0;
+		for (uint32_t i = 0; i < runCount; i++) {
+			Run run;
+			if (!read(file, run.tick.flags) || !read(file, run.count)) {
+				return false;
+			}
+			if (run.tick.flags & Click) {
+				if (!read(file, run.tick.mouseX) || !read(file, run.tick.mouseY)) {
+					return false;
+				}
+			}
+			ticks += run.count;
+			runs.push_back(run);
+		}
+		return ticks == tickCount;
+	}
+
+	template <typename T>
+	static void write(std::ofstream& file, const T& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	static bool read(std::ifstream& file, T& value) {
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef IRRKLANG_BACKEND_H
+#define IRRKLANG_BACKEND_H
+
+#include <irrKlang.h>
+
+#include <string>
+#include <vector>
+
+#include "audio_backend.h"
+
+// The irrKlang device. Sounds are preloaded ISoundSources and every voice slot
+// holds the tracked ISound it plays, dropped again when the slot is freed.
+class IrrKlangAudioBackend : public AudioBackend {
+public:
+	// nullptr when irrKlang finds no usable output device
+	static IrrKlangAudioBackend* Create() {
+		irrklang::ISoundEngine* engine = irrklang::createIrrKlangDevice();
+		return engine ? new IrrKlangAudioBackend(engine) : nullptr;
+	}
+
+	~IrrKlangAudioBackend() override {
+		for (size_t i = 0; i < voices.size(); i++) {
+			Stop(static_cast<int>(i));
+		}
+		engine->drop();
+	}
+
+	IrrKlangAudioBackend(const IrrKlangAudioBackend&) = delete;
+	IrrKlangAudioBackend& operator=(const IrrKlangAudioBackend&) = delete;
+
+	const char* Name() const override {
+		return "irrKlang";
+	}
+
+	int LoadSound(const std::string& path) override {
+		irrklang::ISoundSource* source = engine->addSoundSourceFromFile(path.c_str(), irrklang::ESM_AUTO_DETECT, true);
+		if (!source) {
+			return -1;
+		}
+		sources.push_back(source);
+		return static_cast<int>(sources.size()) - 1;
+	}
+
+	void SetVoiceCount(int count) override {
+		for (size_t i = 0; i < voices.size(); i++) {
+			Stop(static_cast<int>(i));
+		}
+		voices.assign(count, nullptr);
+	}
+
+	bool Play(int sound, int voice) override {
+		voices[voice] = engine->play2D(sources[sound], false, false, true);
+		return voices[voice] != nullptr;
+	}
+
+	bool IsFinished(int voice) override {
+		return !voices[voice] || voices[voice]->isFinished();
+	}
+
+	void Stop(int voice) override {
+		if (voices[voice]) {
+			voices[voice]->stop();
+			voices[voice]->drop();
+			voices[voice] = nullptr;
+		}
+	}
+
+private:
+	irrklang::ISoundEngine* engine;
+	std::vector<irrklang::ISoundSource*> sources;
+	std::vector<irrklang::ISound*> voices;	// per slot, nullptr when free
+
+	explicit IrrKlangAudioBackend(irrklang::ISoundEngine* engine) : engine(engine) {
+	}
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef ITEM_TYPES_H
+#define ITEM_TYPES_H
+
+// Static description of every item. Food::type and FlyingObject::type are indices
+// into itemTypes, so spawning, the collision response and rendering only look values
+// up here. Adding a type means adding an entry, not a new branch.
+struct ItemType {
+	const char* name;
+	const char* model;			// file in objects/, nullptr for the laser quad built in main
+	int texture;				// textureID uniform of shader.frag
+	float scale;
+	bool spins;					// turns around Y with the frame time
+	bool hurts;					// costs a life on the plate unless invincible, otherwise it is collected
+	int powerup;				// powerup granted when collected, -1 for none
+	const char* powerupLabel;	// HUD text for that powerup
+	const char* collectSound;	// played when collected or caught
+	const char* hurtSound;		// played when it costs a life
+	bool clickable;				// can be caught by clicking its screen box
+	bool laser;					// fired by the alien: followed by it, destroyed by rockets, not counted as dropped
+	bool rocket;				// fired from the plate with the rockets powerup, never spawned from above
+	float spawnHeight;
+	int spawnWeight;			// relative chance among the random spawns
+	int spawnEvery;				// forced on every n-th spawn instead, 0 for none
+};
+
+constexpr ItemType itemTypes[] = {
+	//  name       model            tex  scale   spins  hurts  powerup  label      collect sound       hurt sound    click  laser  rocket height  weight  every
+	{ "croissant", "croissant.obj", 3,   0.2f,   true,  false, -1,      nullptr,   "pickup_sound.wav", nullptr,      false, false, false, 1.20f,  1,      0 },
+	{ "cup",       "togocup.obj",   4,   0.045f, true,  false, -1,      nullptr,   "pickup_sound.wav", nullptr,      false, false, false, 1.20f,  1,      0 },
+	{ "gus",       "gus2.obj",      5,   0.03f,  true,  false, -1,      nullptr,   "pickup_sound.wav", nullptr,      false, false, false, 1.20f,  1,      0 },
+	{ "muffin",    "muffin2.obj",   6,   0.04f,  true,  false, -1,      nullptr,   "pickup_sound.wav", nullptr,      false, false, false, 1.20f,  1,      0 },
+	{ "laser",     nullptr,         -1,  1.0f,   false, true,  -1,      nullptr,   nullptr,            "laser2.wav", false, true,  false, 0.88f,  0,      3 },
+	{ "devil",     "devil.obj",     7,   0.08f,  false, true,  -1,      nullptr,   "pickup_sound.wav", "laser2.wav", true,  false, false, 1.20f,  1,      0 },
+	{ "carrot",    "carrot.obj",    1,   0.1f,   true,  false, 0,       "Carrot!", "pickup_sound.wav", nullptr,      false, false, false, 1.20f,  1,      0 },
+	{ "wine",      "wine.obj",      8,   0.04f,  true,  false, 1,       "Wine!",   "pickup_sound.wav", nullptr,      false, false, false, 1.20f,  1,      0 },
+	{ "rocket",    "rocket.obj",    10,  0.045f, true,  false, -1,      nullptr,   nullptr,            nullptr,      false, false, true,  0.0f,   0,      0 }
+};
+
+constexpr int ItemTypeCount = sizeof(itemTypes) / sizeof(itemTypes[0]);
+
+// Food::type of a laser destroyed by a rocket
+constexpr int ItemRemoved = -1;
+
+// Powerup ids granted by the items above
+constexpr int PowerupInvincibility = 0;
+constexpr int PowerupRockets = 1;
+
+constexpr int totalSpawnWeight() {
+	int total = 0;
+	for (int t = 0; t < ItemTypeCount; t++)
+		total += itemTypes[t].spawnWeight;
+	return total;
+}
+
+static_assert(totalSpawnWeight() > 0, "at least one item type must spawn randomly");
+
+// First type fired by the alien, -1 if there is none
+constexpr int laserItemType() {
+	for (int t = 0; t < ItemTypeCount; t++)
+		if (itemTypes[t].laser)
+			return t;
+	return -1;
+}
+
+// Type of the rockets fired from the plate, -1 if there is none
+constexpr int rocketItemType() {
+	for (int t = 0; t < ItemTypeCount; t++)
+		if (itemTypes[t].rocket)
+			return t;
+	return -1;
+}
+
+#endif
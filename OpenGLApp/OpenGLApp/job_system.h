@@ -0,0 +1,219 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts the unfinished jobs of one batch. Wait() on it returns once all of them ran
+struct JobCounter {
+	std::atomic<int> pending;
+
+	JobCounter() : pending(0) {
+	}
+};
+
+// Small work-stealing job system for per-frame data parallel stages.
+// Every worker owns a deque: it pushes and pops its own jobs at the back and
+// other threads steal from the front when they run dry. Threads that are not
+// workers (main and simulation thread) submit into one shared deque.
+// A thread waiting on a counter runs queued jobs instead of blocking, so
+// ParallelFor can be called from any thread, including from inside a job.
+class JobSystem {
+public:
+	typedef void (*JobFunction)(const void* data, size_t begin, size_t end);
+
+	struct Job {
+		JobFunction function;
+		const void* data;
+		size_t begin;
+		size_t end;
+		JobCounter* counter;
+	};
+
+	// workerCount threads are started; the threads calling Wait() work as well,
+	// so 0 is valid and runs everything on the caller
+	explicit JobSystem(unsigned int workerCount) : running(true), queuedJobs(0) {
+		for (unsigned int i = 0; i <= workerCount; i++)
+			queues.push_back(std::unique_ptr<Queue>(new Queue()));
+		for (unsigned int i = 0; i < workerCount; i++)
+			workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+	}
+
+	~JobSystem() {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			running = false;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i].join();
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	unsigned int WorkerCount() const {
+		return static_cast<unsigned int>(workers.size());
+	}
+
+	// Queues function(data, begin, end); data must stay alive until the counter is waited on
+	void Submit(JobFunction function, const void* data, size_t begin, size_t end, JobCounter& counter) {
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+		push(Job{ function, data, begin, end, &counter });
+		notify(false);
+	}
+
+	// Runs queued jobs until every job counted by counter has finished
+	void Wait(JobCounter& counter) {
+		while (counter.pending.load(std::memory_order_acquire) > 0) {
+			Job job;
+			if (findJob(job))
+				execute(job);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	// Calls body(begin, end) on chunks of at most grain elements covering [0, count).
+	// Ranges that fit in one chunk run directly on the caller without touching a queue
+	template <typename F>
+	void ParallelFor(size_t count, size_t grain, const F& body) {
+		if (count == 0)
+			return;
+		if (grain == 0)
+			grain = 1;
+		if (count <= grain || workers.empty()) {
+			body(size_t(0), count);
+			return;
+		}
+
+		JobCounter counter;
+		size_t chunks = (count + grain - 1) / grain;
+		counter.pending.fetch_add(static_cast<int>(chunks - 1), std::memory_order_relaxed);
+		{
+			Queue& queue = *queues[ownQueue()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			for (size_t c = chunks - 1; c > 0; c--) {
+				size_t end = (c + 1) * grain < count ? (c + 1) * grain : count;
+				queue.jobs.push_back(Job{ &invoke<F>, &body, c * grain, end, &counter });
+			}
+		}
+		queuedJobs.fetch_add(static_cast<int>(chunks - 1), std::memory_order_release);
+		notify(true);
+
+		// The first chunk is ours
+		body(size_t(0), grain);
+		Wait(counter);
+	}
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;	// one per worker, the last one is shared by other threads
+	std::vector<std::thread> workers;
+	bool running;
+	std::atomic<int> queuedJobs;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+
+	template <typename F>
+	static void invoke(const void* data, size_t begin, size_t end) {
+		(*static_cast<const F*>(data))(begin, end);
+	}
+
+	// Index of the calling thread's queue
+	size_t ownQueue() const {
+		return workerIndex() >= 0 && workerOwner() == this ? static_cast<size_t>(workerIndex()) : queues.size() - 1;
+	}
+
+	static int& workerIndex() {
+		static thread_local int index = -1;
+		return index;
+	}
+
+	static const JobSystem*& workerOwner() {
+		static thread_local const JobSystem* owner = nullptr;
+		return owner;
+	}
+
+	void push(const Job& job) {
+		Queue& queue = *queues[ownQueue()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(job);
+		}
+		queuedJobs.fetch_add(1, std::memory_order_release);
+	}
+
+	// Newest job of our own queue first (still warm in cache), then the oldest job of the others
+	bool findJob(Job& job) {
+		if (queuedJobs.load(std::memory_order_acquire) <= 0)
+			return false;
+
+		size_t own = ownQueue();
+		{
+			Queue& queue = *queues[own];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty()) {
+				job = queue.jobs.back();
+				queue.jobs.pop_back();
+				queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		for (size_t i = 1; i < queues.size(); i++) {
+			Queue& victim = *queues[(own + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.jobs.empty()) {
+				job = victim.jobs.front();
+				victim.jobs.pop_front();
+				queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void execute(const Job& job) {
+		job.function(job.data, job.begin, job.end);
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	void notify(bool all) {
+		// Taking the lock orders the new jobs before a worker that is about to sleep checks for them
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		if (all)
+			wake.notify_all();
+		else
+			wake.notify_one();
+	}
+
+	void workerLoop(unsigned int index) {
+		workerIndex() = static_cast<int>(index);
+		workerOwner() = this;
+		while (true) {
+			Job job;
+			if (findJob(job)) {
+				execute(job);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock, [this] { return !running || queuedJobs.load(std::memory_order_acquire) > 0; });
+			if (!running)
+				return;
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,401 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mpsc_queue.h"
+
+enum class LogLevel : uint8_t { Debug, Info, Warn, Error };
+
+// Messages below this level are compiled out together with their arguments.
+// Release builds (NDEBUG) start at Info, define it to 0..4 to choose another level
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL 1
+#else
+#define LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// One argument of a message, copied when it is logged and formatted on the log thread
+struct LogArg {
+	enum Type : uint8_t { Int, Uint, Real, Text };
+
+	Type type;
+	union {
+		int64_t i;
+		uint64_t u;
+		double d;
+		const char* s;
+	};
+
+	LogArg() : type(Int), i(0) {}
+	LogArg(bool value) : type(Text), s(value ? "true" : "false") {}
+	LogArg(int value) : type(Int), i(value) {}
+	LogArg(long value) : type(Int), i(value) {}
+	LogArg(long long value) : type(Int), i(value) {}
+	LogArg(unsigned int value) : type(Uint), u(value) {}
+	LogArg(unsigned long value) : type(Uint), u(value) {}
+	LogArg(unsigned long long value) : type(Uint), u(value) {}
+	LogArg(float value) : type(Real), d(value) {}
+	LogArg(double value) : type(Real), d(value) {}
+	// Only the pointer is kept: pass literals or names that live as long as the program
+	LogArg(const char* value) : type(Text), s(value ? value : "(null)") {}
+};
+
+// Leveled log written by a background thread.
+// Write() copies the format pointer, a timestamp and the arguments into a lock-free
+// queue and returns; the log thread drains it every few milliseconds, replaces each
+// {} of the format with the next argument and writes whole batches to stdout, so
+// the game and simulation threads never format text or wait on the console. In
+// binary mode the records go to a file unformatted, each format once, and Decode()
+// turns the file into text later. A full queue drops the message and the log
+// thread reports how many went missing.
+class Logger {
+public:
+	static const size_t QueueCapacity = 1024;
+	static const int MaxArgs = 6;
+
+	Logger() : start(Clock::now()) {
+	}
+
+	~Logger() {
+		Stop();
+	}
+
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	// Text on stdout, or with binaryPath the records in that file. False if it cannot be created
+	bool Start(const std::string& binaryPath = std::string()) {
+		if (running) {
+			return true;
+		}
+		if (!binaryPath.empty()) {
+			binary.open(binaryPath, std::ios::binary | std::ios::trunc);
+			if (!binary) {
+				return false;
+			}
+			uint32_t version = Version;
+			binary.write(magic(), 4);
+			write(binary, version);
+		}
+		running = true;
+		thread = std::thread(&Logger::run, this);
+		return true;
+	}
+
+	// Writes the messages still queued and joins the log thread
+	void Stop() {
+		if (running) {
+			running = false;
+			thread.join();
+		}
+		if (binary.is_open()) {
+			binary.close();
+		}
+		formatIds.clear();
+	}
+
+	// Waits until every message logged so far was written, e.g. before printing a report
+	void Flush() {
+		uint64_t target = accepted.load(std::memory_order_acquire);
+		while (running && written.load(std::memory_order_acquire) < target) {
+			std::this_thread::sleep_for(pollInterval());
+		}
+	}
+
+	// From any thread. format must be a string literal, see LogArg for text arguments
+	template <typename... Args>
+	void Write(LogLevel level, const char* format, const Args&... args) {
+		static_assert(sizeof...(Args) <= MaxArgs, "Too many log arguments");
+		Record record;
+		record.level = level;
+		record.argc = 0;
+		record.format = format;
+		record.time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+		add(record, args...);
+		if (queue.TryPush(record)) {
+			accepted.fetch_add(1, std::memory_order_release);
+		}
+		else {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	uint64_t Dropped() const {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+	// Prints a file written in binary mode as text, false if it is none or was cut short
+	static bool Decode(const std::string& path, std::ostream& out) {
+		std::ifstream file(path, std::ios::binary);
+		char header[4];
+		uint32_t version = 0;
+		if (!file.read(header, 4) || std::string(header, 4) != std::string(magic(), 4) || !read(file, version) || version != Version) {
+			return false;
+		}
+
+		std::vector<std::string> formats;
+		std::string line;
+		char tag;
+		while (file.get(tag)) {
+			if (tag == 'F') {
+				uint32_t id = 0;
+				std::string format;
+				if (!read(file, id) || !readText(file, format) || id != formats.size()) {
+					return false;
+				}
+				formats.push_back(format);
+				continue;
+			}
+
+			uint8_t level = 0;
+			uint64_t time = 0;
+			uint32_t id = 0;
+			uint8_t argc = 0;
+			if (tag != 'M' || !read(file, level) || !read(file, time) || !read(file, id) || !read(file, argc)
+				|| id >= formats.size() || argc > MaxArgs) {
+				return false;
+			}
+			LogArg args[MaxArgs];
+			std::string texts[MaxArgs];
+			for (int a = 0; a < argc; a++) {
+				uint8_t type = 0;
+				if (!read(file, type)) {
+					return false;
+				}
+				args[a].type = static_cast<LogArg::Type>(type);
+				if (type == LogArg::Text) {
+					if (!readText(file, texts[a])) {
+						return false;
+					}
+					args[a].s = texts[a].c_str();
+				}
+				else if (!read(file, args[a].u)) {
+					return false;
+				}
+			}
+			line.clear();
+			formatLine(static_cast<LogLevel>(level), time, formats[id].c_str(), args, argc, line);
+			out << line;
+		}
+		out.flush();
+		return true;
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+	static const uint32_t Version = 1;
+
+	struct Record {
+		LogLevel level;
+		uint8_t argc;
+		const char* format;
+		uint64_t time;		// nanoseconds since the logger was created
+		LogArg args[MaxArgs];
+	};
+
+	static const char* magic() { return "CLOG"; }
+
+	static std::chrono::milliseconds pollInterval() {
+		return std::chrono::milliseconds(5);
+	}
+
+	Clock::time_point start;
+	MpscQueue<Record, QueueCapacity> queue;
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	std::atomic<uint64_t> accepted{ 0 };
+	std::atomic<uint64_t> written{ 0 };
+	std::atomic<uint64_t> dropped{ 0 };
+	uint64_t reportedDrops = 0;
+	std::ofstream binary;
+	std::unordered_map<const char*, uint32_t> formatIds;	// binary mode, formats already in the file
+	std::string text;
+
+	static void add(Record&) {
+	}
+
+	template <typename T, typename... Rest>
+	static void add(Record& record, const T& value, const Rest&... rest) {
+		record.args[record.argc++] = LogArg(value);
+		add(record, rest...);
+	}
+
+	void run() {
+		while (running.load(std::memory_order_acquire)) {
+			drain();
+			std::this_thread::sleep_for(pollInterval());
+		}
+		drain();
+	}
+
+	void drain() {
+		uint64_t count = 0;
+		Record record;
+		while (queue.TryPop(record)) {
+			emit(record);
+			count++;
+		}
+
+		uint64_t lost = dropped.load(std::memory_order_relaxed);
+		if (lost > reportedDrops) {
+			Record warning;
+			warning.level = LogLevel::Warn;
+			warning.argc = 1;
+			warning.format = "{} log messages dropped, the log thread fell behind";
+			warning.time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+			warning.args[0] = LogArg(static_cast<unsigned long long>(lost - reportedDrops));
+			reportedDrops = lost;
+			emit(warning);
+		}
+
+		if (binary.is_open()) {
+			binary.flush();
+		}
+		else if (!text.empty()) {
+			std::cout.write(text.data(), text.size());
+			std::cout.flush();
+			text.clear();
+		}
+		if (count) {
+			written.fetch_add(count, std::memory_order_release);
+		}
+	}
+
+	void emit(const Record& record) {
+		if (!binary.is_open()) {
+			formatLine(record.level, record.time, record.format, record.args, record.argc, text);
+			return;
+		}
+
+		std::unordered_map<const char*, uint32_t>::iterator found = formatIds.find(record.format);
+		if (found == formatIds.end()) {
+			uint32_t id = static_cast<uint32_t>(formatIds.size());
+			found = formatIds.emplace(record.format, id).first;
+			binary.put('F');
+			write(binary, id);
+			writeText(binary, record.format);
+		}
+		uint8_t level = static_cast<uint8_t>(record.level);
+		binary.put('M');
+		write(binary, level);
+		write(binary, record.time);
+		write(binary, found->second);
+		write(binary, record.argc);
+		for (int a = 0; a < record.argc; a++) {
+			const LogArg& arg = record.args[a];
+			uint8_t type = arg.type;
+			write(binary, type);
+			if (arg.type == LogArg::Text)
+				writeText(binary, arg.s);
+			else
+				write(binary, arg.u);
+		}
+	}
+
+	// "[  time s] LEVEL message\n" with every {} of format replaced by the next argument
+	static void formatLine(LogLevel level, uint64_t time, const char* format, const LogArg* args, int argc, std::string& out) {
+		static const char* names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+		char buffer[48];
+		snprintf(buffer, sizeof(buffer), "[%10.3f] %-5s ", time * 1e-9, names[static_cast<int>(level) & 3]);
+		out += buffer;
+
+		int next = 0;
+		for (const char* c = format; *c; c++) {
+			if (c[0] != '{' || c[1] != '}' || next >= argc) {
+				out += *c;
+				continue;
+			}
+			const LogArg& arg = args[next++];
+			switch (arg.type) {
+			case LogArg::Int:
+				snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(arg.i));
+				break;
+			case LogArg::Uint:
+				snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(arg.u));
+				break;
+			case LogArg::Real:
+				snprintf(buffer, sizeof(buffer), "%g", arg.d);
+				break;
+			case LogArg::Text:
+				buffer[0] = '\0';
+				out += arg.s;
+				break;
+			}
+			out += buffer;
+			c++;
+		}
+		out += '\n';
+	}
+
+	template <typename T>
+	static void write(std::ofstream& file, const T& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	static bool read(std::ifstream& file, T& value) {
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	static void writeText(std::ofstream& file, const char* value) {
+		std::string copy(value);
+		uint32_t length = static_cast<uint32_t>(copy.size());
+		write(file, length);
+		file.write(copy.data(), length);
+	}
+
+	static bool readText(std::ifstream& file, std::string& value) {
+		uint32_t length = 0;
+		if (!read(file, length)) {
+			return false;
+		}
+		value.resize(length);
+		return length == 0 || static_cast<bool>(file.read(&value[0], length));
+	}
+};
+
+// Single log shared by every thread of the game
+inline Logger& GameLog() {
+	static Logger log;
+	return log;
+}
+
+// LOG_INFO("Spawned at {} with speed {}", time, speed). Levels below LOG_MIN_LEVEL
+// expand to nothing, so they cost nothing and their arguments are never evaluated
+#if LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(...) GameLog().Write(LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= 1
+#define LOG_INFO(...) GameLog().Write(LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= 2
+#define LOG_WARN(...) GameLog().Write(LogLevel::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= 3
+#define LOG_ERROR(...) GameLog().Write(LogLevel::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef MATERIAL_BINDING_H
+#define MATERIAL_BINDING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "gl_state.h"
+
+// Where one shader program takes the material inputs, and the values it holds.
+// There is one per GL program, see ProgramMaterialUniforms(); the locations are
+// looked up by name the first time a material is applied with it, never again
+// after that. MaterialBinding owns diffuseColor, useTexture and the material
+// samplers: code that sets them on the program directly must call Invalidate().
+struct MaterialUniforms {
+	static const int MaxSamplers = 4;	// per texture kind: material.texture_diffuse1..4, material.texture_specular1..4
+
+	// The uniform values a material sets, compared to skip the upload when they repeat
+	struct Values {
+		glm::vec4 diffuseColor;
+		bool useTexture;
+		uint8_t textureCount;
+		uint8_t specularMask;	// bit i: unit i holds a specular map, else a diffuse one
+
+		bool operator==(const Values& other) const {
+			return diffuseColor == other.diffuseColor && useTexture == other.useTexture &&
+				textureCount == other.textureCount && specularMask == other.specularMask;
+		}
+	};
+
+	bool resolved = false;
+	bool applied = false;		// current holds what the program was last given
+	GLint diffuseColor = -1;
+	GLint useTexture = -1;
+	GLint diffuseSamplers[MaxSamplers];
+	GLint specularSamplers[MaxSamplers];
+	Values current;
+
+	void Resolve(GLuint program) {
+		diffuseColor = glGetUniformLocation(program, "diffuseColor");
+		useTexture = glGetUniformLocation(program, "useTexture");
+		for (int i = 0; i < MaxSamplers; i++) {
+			diffuseSamplers[i] = glGetUniformLocation(program, ("material.texture_diffuse" + std::to_string(i + 1)).c_str());
+			specularSamplers[i] = glGetUniformLocation(program, ("material.texture_specular" + std::to_string(i + 1)).c_str());
+		}
+		resolved = true;
+		applied = false;
+	}
+
+	// The program was given material values behind MaterialBinding's back
+	void Invalidate() {
+		applied = false;
+	}
+};
+
+// The material uniforms of program, shared by every Shader object that uses it, so
+// copies of a Shader agree on what the program holds
+inline MaterialUniforms& ProgramMaterialUniforms(GLuint program) {
+	static std::unordered_map<GLuint, MaterialUniforms> programs;
+	return programs[program];
+}
+
+// A mesh material resolved at load time: the texture of every unit, the diffuse
+// color and whether the shader samples the textures. Apply() does no string work,
+// uploads the uniforms only when the program holds other values and binds the
+// textures through the GLState() cache, so drawing the meshes of a model one
+// after another sets the material once.
+class MaterialBinding {
+public:
+	enum Kind { Diffuse, Specular };
+
+	static const int MaxTextures = 2 * MaterialUniforms::MaxSamplers;
+
+	MaterialBinding() {
+		values.diffuseColor = glm::vec4(1.0f);
+		values.useTexture = false;
+		values.textureCount = 0;
+		values.specularMask = 0;
+	}
+
+	// The texture goes on the next unit. False once every unit or sampler of its kind is taken
+	bool AddTexture(GLuint id, Kind kind) {
+		int sameKind = 0;
+		for (int i = 0; i < values.textureCount; i++) {
+			if (((values.specularMask >> i) & 1) == (kind == Specular ? 1 : 0)) {
+				sameKind++;
+			}
+		}
+		if (values.textureCount >= MaxTextures || sameKind >= MaterialUniforms::MaxSamplers) {
+			return false;
+		}
+		if (kind == Specular) {
+			values.specularMask |= 1 << values.textureCount;
+		}
+		textures[values.textureCount++] = id;
+		values.useTexture = true;
+		return true;
+	}
+
+	void SetDiffuseColor(const glm::vec4& color) {
+		values.diffuseColor = color;
+	}
+
+	// Sets the material on program, which must be in use, and binds its textures
+	void Apply(GLuint program, MaterialUniforms& uniforms) const {
+		if (!uniforms.resolved) {
+			uniforms.Resolve(program);
+		}
+		if (!uniforms.applied || !(uniforms.current == values)) {
+			glUniform4fv(uniforms.diffuseColor, 1, &values.diffuseColor[0]);
+			glUniform1i(uniforms.useTexture, values.useTexture ? 1 : 0);
+			int diffuseNr = 0;
+			int specularNr = 0;
+			for (int i = 0; i < values.textureCount; i++) {
+				bool specular = ((values.specularMask >> i) & 1) != 0;
+				glUniform1i(specular ? uniforms.specularSamplers[specularNr++] : uniforms.diffuseSamplers[diffuseNr++], i);
+			}
+			uniforms.current = values;
+			uniforms.applied = true;
+		}
+		for (int i = 0; i < values.textureCount; i++) {
+			GLState().BindTexture(i, textures[i]);
+		}
+	}
+
+private:
+	MaterialUniforms::Values values;
+	GLuint textures[MaxTextures];
+};
+
+#endif
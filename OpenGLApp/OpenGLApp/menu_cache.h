@@ -0,0 +1,94 @@
+#ifndef MENU_CACHE_H
+#define MENU_CACHE_H
+
+#include <glad/glad.h>
+
+// Offscreen copy of one static menu screen.
+// The screen is drawn into a framebuffer only after Invalidate() or a window
+// resize; every other frame Present() copies it to the window in one blit
+// instead of drawing the screen again.
+class MenuCache {
+public:
+	MenuCache() {
+	}
+
+	~MenuCache() {
+		release();
+	}
+
+	MenuCache(const MenuCache&) = delete;
+	MenuCache& operator=(const MenuCache&) = delete;
+
+	// Marks the cached screen as outdated, the next BeginRedraw() returns true
+	void Invalidate() {
+		dirty = true;
+	}
+
+	// Returns true and binds the offscreen framebuffer when the screen has to be drawn again.
+	// Draw it as usual, then call EndRedraw()
+	bool BeginRedraw(int framebufferWidth, int framebufferHeight) {
+		if (framebufferWidth <= 0 || framebufferHeight <= 0) {
+			return false;
+		}
+		if (framebufferWidth != width || framebufferHeight != height) {
+			allocate(framebufferWidth, framebufferHeight);
+		}
+		else if (!dirty) {
+			return false;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		dirty = false;
+		return true;
+	}
+
+	void EndRedraw() {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	// Copies the cached screen over the whole window
+	void Present() const {
+		if (!framebuffer) {
+			return;
+		}
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+private:
+	GLuint framebuffer = 0;
+	GLuint colorBuffer = 0;
+	int width = 0;
+	int height = 0;
+	bool dirty = true;
+
+	void allocate(int newWidth, int newHeight) {
+		release();
+		width = newWidth;
+		height = newHeight;
+
+		glGenRenderbuffers(1, &colorBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		dirty = true;
+	}
+
+	void release() {
+		if (framebuffer) {
+			glDeleteFramebuffers(1, &framebuffer);
+			glDeleteRenderbuffers(1, &colorBuffer);
+		}
+		framebuffer = 0;
+		colorBuffer = 0;
+		width = 0;
+		height = 0;
+	}
+};
+
+#endif
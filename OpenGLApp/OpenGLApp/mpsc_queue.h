@@ -0,0 +1,73 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for any number of producer threads and one consumer thread.
+// Every slot carries a sequence number: producers claim a slot by advancing the
+// tail with a compare and swap and publish it through its sequence, so a producer
+// never waits for another one to finish writing. Capacity must be a power of two;
+// a full queue rejects new items instead of blocking.
+template <typename T, size_t Capacity>
+class MpscQueue {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	MpscQueue() : head(0), tail(0) {
+		for (size_t i = 0; i < Capacity; i++) {
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	// Producer side, from any thread
+	bool TryPush(const T& item) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		for (;;) {
+			Slot& slot = slots[t & (Capacity - 1)];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			if (sequence == t) {
+				if (tail.compare_exchange_weak(t, t + 1, std::memory_order_relaxed)) {
+					slot.item = item;
+					slot.sequence.store(t + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (sequence < t) {
+				// The slot still holds the item from one lap ago
+				return false;
+			}
+			else {
+				t = tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Consumer side
+	bool TryPop(T& item) {
+		Slot& slot = slots[head & (Capacity - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+			return false;
+		}
+		item = slot.item;
+		slot.sequence.store(head + Capacity, std::memory_order_release);
+		head++;
+		return true;
+	}
+
+private:
+	struct Slot {
+		std::atomic<size_t> sequence;	// index of the push that may write it, +1 once written
+		T item;
+	};
+
+	Slot slots[Capacity];
+	// Kept on separate cache lines so the consumer does not false-share with the producers
+	alignas(64) size_t head;				// next item to pop, consumer only
+	alignas(64) std::atomic<size_t> tail;	// next slot to claim, shared by the producers
+};
+
+#endif
@@ -1,15 +1,21 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec2 aTexCoords;
+layout(location = 2) in vec3 aNormal; // quads leave this disabled and get the default (0, 0, 1)
 
 out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform mat3 normalMatrix; // computed once per draw on the CPU
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = normalMatrix * aNormal;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
     TexCoords = aTexCoords; // Pass texture coordinates to fragment shader
 }
@@ -4,6 +4,9 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "gl_state.h"
+#include "material_binding.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -13,6 +16,8 @@ class Shader
 {
 public:
     unsigned int ID;
+    // Where this program takes the mesh material, shared with other Shaders of ID, see MaterialBinding
+    MaterialUniforms* materialUniforms;
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath)
@@ -68,13 +73,15 @@ public:
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
-
+        // GL may hand out the id of a deleted program again, start from a clean cache
+        materialUniforms = &ProgramMaterialUniforms(ID);
+        *materialUniforms = MaterialUniforms();
     }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() const
     {
-        glUseProgram(ID);
+        GLState().UseProgram(ID);
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
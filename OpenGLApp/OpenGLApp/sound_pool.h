@@ -0,0 +1,222 @@
+#ifndef SOUND_POOL_H
+#define SOUND_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "audio_backend.h"
+
+// How a sound may use the voices of a SoundPool
+struct SoundVoicePolicy {
+	int maxVoices;			// of this sound at once, its oldest voice is stolen beyond that
+	int priority;			// a full pool steals the voice of a lower or equal priority, else drops the event
+	double coalesceWindow;	// seconds after a start of this sound in which another start is merged into it
+};
+
+// What became of one sound event
+enum class SoundOutcome { Played, Coalesced, Dropped, Stole };
+
+// Sound events with a voice budget.
+// A dense wave can trigger the same pickup many times in one frame; spawning a
+// voice for each only makes the mix louder and costs a voice every time.
+// Every sound is loaded once by the backend, events within its coalescing
+// window merge into the voice that just started, and no more than the per sound
+// cap and the global budget of voices play at once. Not thread safe: use it from
+// one thread. Find() and the counters can be read from any thread once every
+// sound was added.
+class SoundPool {
+public:
+	struct Counters {
+		uint64_t played;
+		uint64_t coalesced;	// merged into a voice that had just started
+		uint64_t dropped;	// no voice was free and none could be stolen
+		uint64_t stolen;	// voices stopped early for a newer or more important event
+	};
+
+	static const int DefaultVoiceBudget = 12;
+
+	SoundPool(AudioBackend& backend, int voiceBudget = DefaultVoiceBudget) : backend(backend) {
+		backend.SetVoiceCount(voiceBudget);
+		voices.reserve(voiceBudget);
+		for (int slot = voiceBudget; slot-- > 0;) {
+			freeSlots.push_back(slot);
+		}
+	}
+
+	~SoundPool() {
+		for (size_t i = 0; i < voices.size(); i++) {
+			backend.Stop(voices[i].slot);
+		}
+	}
+
+	SoundPool(const SoundPool&) = delete;
+	SoundPool& operator=(const SoundPool&) = delete;
+
+	// Loads the file at path, played by Play(Find(name)). -1 if the backend cannot play it
+	int Add(const char* name, const std::string& path, const SoundVoicePolicy& policy) {
+		int source = backend.LoadSound(path);
+		if (source < 0) {
+			return -1;
+		}
+		Sound sound;
+		sound.name = name;
+		sound.source = source;
+		sound.policy = policy;
+		sounds.push_back(sound);
+		return static_cast<int>(sounds.size()) - 1;
+	}
+
+	// A handful of sounds, so a linear search beats hashing the name. -1 if never added
+	int Find(const char* name) const {
+		for (size_t i = 0; i < sounds.size(); i++) {
+			if (sounds[i].name == name || strcmp(sounds[i].name, name) == 0) {
+				return static_cast<int>(i);
+			}
+		}
+		return -1;
+	}
+
+	const char* Name(int sound) const {
+		return sounds[sound].name;
+	}
+
+	size_t SoundCount() const {
+		return sounds.size();
+	}
+
+	// Starts a voice of sound unless the event is coalesced or dropped. now is in seconds
+	SoundOutcome Play(int sound, double now) {
+		if (sound < 0 || sound >= static_cast<int>(sounds.size())) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return SoundOutcome::Dropped;
+		}
+		Sound& entry = sounds[sound];
+		Reap();
+
+		if (entry.started && now - entry.lastStart < entry.policy.coalesceWindow) {
+			coalesced.fetch_add(1, std::memory_order_relaxed);
+			return SoundOutcome::Coalesced;
+		}
+
+		// At its own cap a sound replaces its oldest voice, a full pool its least important one
+		bool full = true;
+		int victim = -1;
+		if (countVoices(sound) >= entry.policy.maxVoices) {
+			victim = oldestVoice(sound, entry.policy.priority);
+		}
+		else if (freeSlots.empty()) {
+			victim = oldestVoice(-1, entry.policy.priority);
+		}
+		else {
+			full = false;
+		}
+		if (full) {
+			if (victim < 0) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return SoundOutcome::Dropped;
+			}
+			release(victim);
+			stolen.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		int slot = freeSlots.back();
+		if (!backend.Play(entry.source, slot)) {
+			backend.Stop(slot);
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return SoundOutcome::Dropped;
+		}
+		freeSlots.pop_back();
+		voices.push_back(Voice{ slot, sound, entry.policy.priority, now });
+		activeVoices.store(static_cast<int>(voices.size()), std::memory_order_relaxed);
+		entry.started = true;
+		entry.lastStart = now;
+		played.fetch_add(1, std::memory_order_relaxed);
+		return full ? SoundOutcome::Stole : SoundOutcome::Played;
+	}
+
+	// Gives back the voices that finished playing
+	void Reap() {
+		for (size_t i = voices.size(); i-- > 0;) {
+			if (backend.IsFinished(voices[i].slot)) {
+				release(static_cast<int>(i));
+			}
+		}
+		activeVoices.store(static_cast<int>(voices.size()), std::memory_order_relaxed);
+	}
+
+	int ActiveVoices() const {
+		return activeVoices.load(std::memory_order_relaxed);
+	}
+
+	Counters Stats() const {
+		return Counters{
+			played.load(std::memory_order_relaxed),
+			coalesced.load(std::memory_order_relaxed),
+			dropped.load(std::memory_order_relaxed),
+			stolen.load(std::memory_order_relaxed) };
+	}
+
+private:
+	struct Sound {
+		const char* name;
+		int source;
+		SoundVoicePolicy policy;
+		bool started = false;
+		double lastStart = 0.0;
+	};
+
+	struct Voice {
+		int slot;
+		int sound;
+		int priority;
+		double start;
+	};
+
+	AudioBackend& backend;
+	std::vector<Sound> sounds;
+	std::vector<Voice> voices;
+	std::vector<int> freeSlots;
+	std::atomic<int> activeVoices{ 0 };
+	std::atomic<uint64_t> played{ 0 };
+	std::atomic<uint64_t> coalesced{ 0 };
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<uint64_t> stolen{ 0 };
+
+	int countVoices(int sound) const {
+		int count = 0;
+		for (size_t i = 0; i < voices.size(); i++) {
+			if (voices[i].sound == sound) {
+				count++;
+			}
+		}
+		return count;
+	}
+
+	// Oldest voice of the lowest priority not above maxPriority, of sound or any sound for -1
+	int oldestVoice(int sound, int maxPriority) const {
+		int best = -1;
+		for (size_t i = 0; i < voices.size(); i++) {
+			const Voice& voice = voices[i];
+			if ((sound >= 0 && voice.sound != sound) || voice.priority > maxPriority) {
+				continue;
+			}
+			if (best < 0 || voice.priority < voices[best].priority ||
+				(voice.priority == voices[best].priority && voice.start < voices[best].start)) {
+				best = static_cast<int>(i);
+			}
+		}
+		return best;
+	}
+
+	void release(int index) {
+		backend.Stop(voices[index].slot);
+		freeSlots.push_back(voices[index].slot);
+		voices[index] = voices.back();
+		voices.pop_back();
+	}
+};
+
+#endif
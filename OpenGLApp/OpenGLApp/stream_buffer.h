@@ -0,0 +1,187 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+
+// Ring allocator for vertex data that changes every frame (text quads, debug
+// lines, per-instance data). One GL buffer is created at startup and never
+// reallocated, so uploads neither create GL objects nor wait on the GPU.
+//
+// On GL 4.4+ the buffer is allocated with glBufferStorage and mapped once
+// (persistent + coherent). It is split into one segment per frame in flight
+// and a fence guards each segment before it is written again.
+// On GL 3.3 every allocation maps its range unsynchronized and the whole
+// store is orphaned with glBufferData(NULL) when the ring wraps around.
+class StreamBuffer {
+public:
+	static const int FramesInFlight = 3;
+
+	struct Allocation {
+		void* ptr = nullptr;	// where to write, valid until Commit()
+		GLintptr offset = 0;	// byte offset inside Buffer()
+	};
+
+	struct Counters {
+		unsigned int allocations = 0;
+		unsigned int bytes = 0;
+		unsigned int stalls = 0;	// waits on a fence that was not signaled yet
+		unsigned int orphans = 0;	// GL 3.3 buffer respecifications
+	};
+
+	explicit StreamBuffer(GLsizeiptr bytesPerFrame) : segmentSize(bytesPerFrame) {
+		persistent = GLAD_GL_VERSION_4_4 != 0;
+		totalSize = segmentSize * FramesInFlight;
+
+		glGenBuffers(1, &buffer);
+		GLState().BindBuffer(GL_ARRAY_BUFFER, buffer);
+		if (persistent) {
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, totalSize, NULL, flags);
+			mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, totalSize, flags));
+		}
+		else {
+			glBufferData(GL_ARRAY_BUFFER, totalSize, NULL, GL_STREAM_DRAW);
+		}
+		for (int i = 0; i < FramesInFlight; i++)
+			fences[i] = 0;
+	}
+
+	~StreamBuffer() {
+		for (int i = 0; i < FramesInFlight; i++) {
+			if (fences[i])
+				glDeleteSync(fences[i]);
+		}
+		if (persistent && mapped) {
+			GLState().BindBuffer(GL_ARRAY_BUFFER, buffer);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		}
+		GLState().DeleteBuffer(buffer);
+	}
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	GLuint Buffer() const {
+		return buffer;
+	}
+
+	bool IsPersistent() const {
+		return persistent;
+	}
+
+	// Waits (only if the GPU is behind) until this frame's segment is free again
+	void BeginFrame() {
+		last = current;
+		current = Counters();
+
+		if (!persistent)
+			return;
+		segment = (segment + 1) % FramesInFlight;
+		waitFence(fences[segment]);
+		head = segment * segmentSize;
+	}
+
+	// Fences everything written during the frame
+	void EndFrame() {
+		if (!persistent)
+			return;
+		if (fences[segment])
+			glDeleteSync(fences[segment]);
+		fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	// Reserves size bytes whose offset is a multiple of alignment, so a
+	// vertex stream with that stride can be drawn starting at offset / alignment.
+	// The GL_ARRAY_BUFFER binding is left on Buffer().
+	Allocation Allocate(GLsizeiptr size, GLsizeiptr alignment) {
+		Allocation allocation;
+		if (size <= 0 || size > segmentSize)
+			return allocation;
+
+		GLState().BindBuffer(GL_ARRAY_BUFFER, buffer);
+		if (persistent) {
+			GLintptr end = (segment + 1) * segmentSize;
+			GLintptr offset = alignUp(head, alignment);
+			if (offset + size > end) {
+				// The frame outgrew its segment: wait for the draws already issued
+				// from it and start over at the beginning.
+				GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				waitFence(sync);
+				offset = alignUp(segment * segmentSize, alignment);
+				if (offset + size > end)
+					return allocation;
+			}
+			head = offset + size;
+			allocation.offset = offset;
+			allocation.ptr = mapped + offset;
+		}
+		else {
+			GLintptr offset = alignUp(head, alignment);
+			if (offset + size > totalSize) {
+				glBufferData(GL_ARRAY_BUFFER, totalSize, NULL, GL_STREAM_DRAW);
+				current.orphans++;
+				offset = 0;
+			}
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+			allocation.ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, flags);
+			allocation.offset = offset;
+			head = offset + size;
+			pendingUnmap = allocation.ptr != nullptr;
+		}
+
+		current.allocations++;
+		current.bytes += static_cast<unsigned int>(size);
+		return allocation;
+	}
+
+	// Must be called once the data of the last Allocate() has been written
+	void Commit() {
+		if (!pendingUnmap)
+			return;
+		GLState().BindBuffer(GL_ARRAY_BUFFER, buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		pendingUnmap = false;
+	}
+
+	const Counters& LastFrame() const {
+		return last;
+	}
+
+private:
+	GLuint buffer = 0;
+	bool persistent = false;
+	unsigned char* mapped = nullptr;
+	GLsizeiptr segmentSize;
+	GLsizeiptr totalSize;
+	GLintptr head = 0;
+	int segment = 0;
+	bool pendingUnmap = false;
+	GLsync fences[FramesInFlight];
+
+	Counters current;
+	Counters last;
+
+	static GLintptr alignUp(GLintptr value, GLsizeiptr alignment) {
+		if (alignment <= 1)
+			return value;
+		return ((value + alignment - 1) / alignment) * alignment;
+	}
+
+	void waitFence(GLsync& fence) {
+		if (!fence)
+			return;
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			current.stalls++;
+			do {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(fence);
+		fence = 0;
+	}
+};
+
+#endif
@@ -1,12 +1,24 @@
 #version 330 core
-in vec2 TexCoords;
+in vec3 TexCoords;
 out vec4 color;
 
-uniform sampler2D text;
+uniform sampler2DArray text;
 uniform vec3 textColor;
+uniform bool distanceField;
+
+// Glyph alpha from coverage, or from the distance to the outline (0.5 on the edge)
+// smoothed over about one screen pixel whatever the scale
+float glyphAlpha()
+{
+    float value = texture(text, TexCoords).r;
+    if (!distanceField)
+        return value;
+    float width = max(fwidth(value) * 0.75, 0.0001);
+    return smoothstep(0.5 - width, 0.5 + width, value);
+}
 
 void main()
 {    
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
+    vec4 sampled = vec4(1.0, 1.0, 1.0, glyphAlpha());
     color = vec4(textColor, 1.0) * sampled;
 }
\ No newline at end of file
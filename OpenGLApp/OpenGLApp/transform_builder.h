@@ -0,0 +1,84 @@
+#ifndef TRANSFORM_BUILDER_H
+#define TRANSFORM_BUILDER_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define TRANSFORM_BUILDER_SSE 1
+#endif
+
+// Per-type part of an instance transform: uniform scale, then a spin around axis
+struct InstanceShape {
+	float scale;
+	glm::vec3 axis;
+	bool spins;
+};
+
+// Builds model = translate(position) * scale(shape.scale) * rotate(angle, shape.axis)
+// for many instances at once. With one angle per frame the upper 3x3 only depends
+// on the type, so it is computed once per type and every instance only adds its
+// translation: positions come in as SoA arrays and are transposed four at a time
+// into the last column of the packed output matrices.
+class TransformBuilder {
+public:
+	static const int MaxShapes = 16;
+
+	// Computes the per-type matrices for this frame; call before Build()
+	void Prepare(const InstanceShape* shapes, int shapeCount, float angle) {
+		for (int t = 0; t < shapeCount && t < MaxShapes; t++) {
+			glm::mat4 m = glm::scale(glm::mat4(1.0f), glm::vec3(shapes[t].scale));
+			if (shapes[t].spins)
+				m = glm::rotate(m, angle, shapes[t].axis);
+			linear[t] = m;
+			normal[t] = glm::transpose(glm::inverse(glm::mat3(m)));
+		}
+	}
+
+	// Writes out[i] for i in [begin, end); types must be valid shape indices
+	void Build(const float* xs, const float* ys, const float* zs, const int* types, size_t begin, size_t end, glm::mat4* out) const {
+		size_t i = begin;
+#ifdef TRANSFORM_BUILDER_SSE
+		for (; i + 4 <= end; i += 4) {
+			__m128 c0 = _mm_loadu_ps(xs + i);
+			__m128 c1 = _mm_loadu_ps(ys + i);
+			__m128 c2 = _mm_loadu_ps(zs + i);
+			__m128 c3 = _mm_set1_ps(1.0f);
+			// Rows x, y, z, 1 of four instances become their four translation columns
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			storeInstance(out[i], linear[types[i]], c0);
+			storeInstance(out[i + 1], linear[types[i + 1]], c1);
+			storeInstance(out[i + 2], linear[types[i + 2]], c2);
+			storeInstance(out[i + 3], linear[types[i + 3]], c3);
+		}
+#endif
+		for (; i < end; i++) {
+			out[i] = linear[types[i]];
+			out[i][3] = glm::vec4(xs[i], ys[i], zs[i], 1.0f);
+		}
+	}
+
+	// Normal matrix shared by every instance of a type
+	const glm::mat3& NormalMatrix(int type) const {
+		return normal[type];
+	}
+
+private:
+	glm::mat4 linear[MaxShapes];
+	glm::mat3 normal[MaxShapes];
+
+#ifdef TRANSFORM_BUILDER_SSE
+	static void storeInstance(glm::mat4& out, const glm::mat4& shape, __m128 translation) {
+		float* dst = &out[0][0];
+		_mm_storeu_ps(dst, _mm_loadu_ps(&shape[0][0]));
+		_mm_storeu_ps(dst + 4, _mm_loadu_ps(&shape[1][0]));
+		_mm_storeu_ps(dst + 8, _mm_loadu_ps(&shape[2][0]));
+		_mm_storeu_ps(dst + 12, translation);
+	}
+#endif
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Lock-free single writer / single reader hand-off of whole values.
+// The writer fills WriteBuffer() and calls Publish(), the reader calls Update()
+// and reads ReadBuffer(). Each side owns one of the three buffers and the third
+// one is swapped through an atomic, so neither side ever waits for the other and
+// the reader always gets the newest complete value (older ones are dropped).
+// WriteBuffer() holds stale data after Publish(): the writer must overwrite all of it.
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : middle(packed(1, false)), writeIndex(0), readIndex(2) {
+	}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	T& WriteBuffer() {
+		return buffers[writeIndex];
+	}
+
+	void Publish() {
+		unsigned int previous = middle.exchange(packed(writeIndex, true), std::memory_order_acq_rel);
+		writeIndex = previous & IndexMask;
+	}
+
+	// Switches ReadBuffer() to the newest published value, returns false if there was none
+	bool Update() {
+		if (!(middle.load(std::memory_order_relaxed) & DirtyBit))
+			return false;
+		unsigned int previous = middle.exchange(packed(readIndex, false), std::memory_order_acq_rel);
+		readIndex = previous & IndexMask;
+		return true;
+	}
+
+	const T& ReadBuffer() const {
+		return buffers[readIndex];
+	}
+
+private:
+	static const unsigned int IndexMask = 3;
+	static const unsigned int DirtyBit = 4;
+
+	T buffers[3];
+	std::atomic<unsigned int> middle;	// index of the shared buffer + DirtyBit when it holds unread data
+	unsigned int writeIndex;			// only touched by the writer
+	unsigned int readIndex;				// only touched by the reader
+
+	static unsigned int packed(unsigned int index, bool dirty) {
+		return index | (dirty ? DirtyBit : 0u);
+	}
+};
+
+#endif
@@ -0,0 +1,23 @@
+#version 330 core
+in vec3 TexCoords;
+in vec4 Color;
+out vec4 color;
+
+uniform sampler2DArray text;
+uniform bool distanceField;
+
+// Same glyph alpha as text.frag
+float glyphAlpha()
+{
+    float value = texture(text, TexCoords).r;
+    if (!distanceField)
+        return value;
+    float width = max(fwidth(value) * 0.75, 0.0001);
+    return smoothstep(0.5 - width, 0.5 + width, value);
+}
+
+void main()
+{
+    // Glyphs from the font atlas, its solid block gives filled quads
+    color = Color * vec4(1.0, 1.0, 1.0, glyphAlpha());
+}
\ No newline at end of file
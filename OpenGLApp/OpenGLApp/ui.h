@@ -0,0 +1,275 @@
+#ifndef UI_H
+#define UI_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "shader_s.h"
+#include "gl_state.h"
+#include "font_atlas.h"
+
+enum class UiKind { Panel, Label, Button };
+
+// One node of a UiScreen. Positions are relative to the parent panel, in the
+// SCR_WIDTH x SCR_HEIGHT pixels of renderText with the origin at the bottom left
+struct UiWidget {
+	UiKind kind;
+	int parent;					// -1 for the screen
+	glm::vec2 position;			// text baseline origin, or the bottom left of a panel
+	glm::vec2 size;				// panels only, text widgets are measured
+	std::string text;
+	float scale;
+	glm::vec4 color;			// text color, or the fill of a panel (alpha 0: no fill)
+	int action;					// buttons: returned by HitTest
+	glm::vec2 padding;			// buttons: extra clickable margin around the glyphs
+
+	// Computed by the layout, in screen pixels
+	glm::vec2 min;
+	glm::vec2 max;
+};
+
+// Retained tree of panels, labels and buttons for one screen.
+// The layout (screen rectangles from the glyph metrics, the hit test grid and
+// the vertices of every quad) only runs after the tree changed, and only then
+// are the vertices uploaded again. Drawing is one glDrawArrays with the font
+// atlas bound.
+class UiScreen {
+public:
+	UiScreen(FontAtlas& font, float width, float height) : font(font), width(width), height(height) {
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		GLState().BindVertexArray(VAO);
+		GLState().BindBuffer(GL_ARRAY_BUFFER, VBO);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, page));
+		GLState().BindVertexArray(0);
+	}
+
+	~UiScreen() {
+		GLState().DeleteVertexArray(VAO);
+		GLState().DeleteBuffer(VBO);
+	}
+
+	UiScreen(const UiScreen&) = delete;
+	UiScreen& operator=(const UiScreen&) = delete;
+
+	int AddPanel(const glm::vec2& position, const glm::vec2& size, const glm::vec4& fill, int parent = -1) {
+		return add(UiKind::Panel, parent, position, size, "", 1.0f, fill, -1);
+	}
+
+	int AddLabel(const std::string& text, const glm::vec2& position, float scale, const glm::vec3& color, int parent = -1) {
+		return add(UiKind::Label, parent, position, glm::vec2(0.0f), text, scale, glm::vec4(color, 1.0f), -1);
+	}
+
+	int AddButton(const std::string& text, const glm::vec2& position, float scale, const glm::vec3& color, int action, int parent = -1) {
+		return add(UiKind::Button, parent, position, glm::vec2(0.0f), text, scale, glm::vec4(color, 1.0f), action);
+	}
+
+	void SetText(int id, const std::string& text) {
+		if (widgets[id].text != text) {
+			widgets[id].text = text;
+			layoutDirty = true;
+		}
+	}
+
+	void SetColor(int id, const glm::vec3& color) {
+		if (glm::vec3(widgets[id].color) != color) {
+			widgets[id].color = glm::vec4(color, widgets[id].color.a);
+			layoutDirty = true;
+		}
+	}
+
+	// True until the next Draw() after a change, e.g. to refresh a cached copy of the screen.
+	// Glyphs moving in the font atlas count as a change
+	bool IsDirty() const {
+		return layoutDirty || uploadDirty || fontGeneration != font.Generation();
+	}
+
+	size_t WidgetCount() const {
+		return widgets.size();
+	}
+
+	const UiWidget& Widget(int id) {
+		layout();
+		return widgets[id];
+	}
+
+	// Action of the topmost button containing the point, -1 for none
+	int HitTest(float x, float y) {
+		layout();
+		if (x < 0.0f || y < 0.0f || x >= width || y >= height) {
+			return -1;
+		}
+		const std::vector<int>& cell = cells[cellIndex(x, y)];
+		for (size_t i = cell.size(); i-- > 0;) {
+			const UiWidget& button = widgets[cell[i]];
+			if (x >= button.min.x && x <= button.max.x && y >= button.min.y && y <= button.max.y) {
+				return button.action;
+			}
+		}
+		return -1;
+	}
+
+	// Draws every widget with one call. shader is ui.vs/ui.frag with its projection already set
+	void Draw(Shader& shader) {
+		layout();
+		if (uploadDirty && !vertices.empty()) {
+			// The buffer only grows, shorter texts reuse it
+			GLState().BindBuffer(GL_ARRAY_BUFFER, VBO);
+			if (vertices.size() > bufferCapacity) {
+				glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+				bufferCapacity = vertices.size();
+			}
+			else {
+				glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+			}
+		}
+		uploadDirty = false;
+		if (vertices.empty()) {
+			return;
+		}
+
+		GLState().UseProgram(shader.ID);
+		GLState().SetBlend(true);
+		GLState().BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		GLState().BindTexture(0, font.Texture(), GL_TEXTURE_2D_ARRAY);
+		GLState().BindVertexArray(VAO);
+		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+	}
+
+private:
+	struct Vertex {
+		glm::vec4 position;		// x, y, u, v
+		glm::vec4 color;
+		float page;				// layer of the font atlas
+	};
+
+	static const int CellSize = 64;
+
+	FontAtlas& font;
+	float width;
+	float height;
+	std::vector<UiWidget> widgets;
+	std::vector<std::vector<int>> cells;	// buttons overlapping each grid cell, in tree order
+	std::vector<Vertex> vertices;
+	GLuint VAO = 0;
+	GLuint VBO = 0;
+	size_t bufferCapacity = 0;		// in vertices
+	bool layoutDirty = true;		// widgets changed since the last layout
+	bool uploadDirty = false;		// vertices changed since the last upload
+	unsigned int fontGeneration = 0;	// font atlas generation the vertices were built with
+
+	int add(UiKind kind, int parent, const glm::vec2& position, const glm::vec2& size, const std::string& text, float scale, const glm::vec4& color, int action) {
+		UiWidget widget;
+		widget.kind = kind;
+		widget.parent = parent;
+		widget.position = position;
+		widget.size = size;
+		widget.text = text;
+		widget.scale = scale;
+		widget.color = color;
+		widget.action = action;
+		widget.padding = kind == UiKind::Button ? glm::vec2(4.0f, 4.0f) : glm::vec2(0.0f);
+		widgets.push_back(widget);
+		layoutDirty = true;
+		return static_cast<int>(widgets.size()) - 1;
+	}
+
+	int columns() const {
+		return static_cast<int>(width) / CellSize + 1;
+	}
+
+	int cellIndex(float x, float y) const {
+		return static_cast<int>(y) / CellSize * columns() + static_cast<int>(x) / CellSize;
+	}
+
+	// Parents are always added before their children, so one pass in order resolves the tree
+	void layout() {
+		if (!layoutDirty && fontGeneration == font.Generation()) {
+			return;
+		}
+		layoutDirty = false;
+		uploadDirty = true;
+		// Taken before the glyph lookups: should they evict a page, the next call lays out again
+		fontGeneration = font.Generation();
+
+		vertices.clear();
+		cells.assign(columns() * (static_cast<int>(height) / CellSize + 1), std::vector<int>());
+		for (size_t i = 0; i < widgets.size(); i++) {
+			UiWidget& widget = widgets[i];
+			glm::vec2 origin = widget.position;
+			if (widget.parent >= 0) {
+				origin += widgets[widget.parent].min;
+			}
+
+			if (widget.kind == UiKind::Panel) {
+				widget.min = origin;
+				widget.max = origin + widget.size;
+				if (widget.color.a > 0.0f) {
+					glm::vec3 uv = font.SolidUV();
+					addQuad(widget.min, widget.max, glm::vec4(uv.x, uv.y, uv.x, uv.y), uv.z, widget.color);
+				}
+				continue;
+			}
+
+			font.Bounds(widget.text, origin, widget.scale, widget.min, widget.max);
+			widget.min -= widget.padding;
+			widget.max += widget.padding;
+			addText(widget.text, origin, widget.scale, widget.color);
+			if (widget.kind == UiKind::Button) {
+				index(static_cast<int>(i));
+			}
+		}
+	}
+
+	void index(int id) {
+		const UiWidget& button = widgets[id];
+		int maxColumn = columns() - 1;
+		int maxRow = static_cast<int>(height) / CellSize;
+		int column0 = glm::clamp(static_cast<int>(button.min.x) / CellSize, 0, maxColumn);
+		int column1 = glm::clamp(static_cast<int>(button.max.x) / CellSize, 0, maxColumn);
+		int row0 = glm::clamp(static_cast<int>(button.min.y) / CellSize, 0, maxRow);
+		int row1 = glm::clamp(static_cast<int>(button.max.y) / CellSize, 0, maxRow);
+		for (int row = row0; row <= row1; row++) {
+			for (int column = column0; column <= column1; column++) {
+				cells[row * columns() + column].push_back(id);
+			}
+		}
+	}
+
+	void addText(const std::string& text, glm::vec2 pen, float scale, const glm::vec4& color) {
+		for (size_t i = 0; i < text.size();) {
+			const Character& ch = font.Glyph(NextCodepoint(text, i));
+			if (ch.Page >= 0) {
+				glm::vec2 min(pen.x + ch.Bearing.x * scale, pen.y - (ch.Size.y - ch.Bearing.y) * scale);
+				glm::vec2 max = min + ch.Size * scale;
+				addQuad(min, max, ch.UV, static_cast<float>(ch.Page), color);
+			}
+			pen.x += (ch.Advance >> 6) * scale;
+		}
+	}
+
+	// uv holds left, top, right, bottom like Character::UV
+	void addQuad(const glm::vec2& min, const glm::vec2& max, const glm::vec4& uv, float page, const glm::vec4& color) {
+		Vertex topLeft = { glm::vec4(min.x, max.y, uv.x, uv.y), color, page };
+		Vertex bottomLeft = { glm::vec4(min.x, min.y, uv.x, uv.w), color, page };
+		Vertex bottomRight = { glm::vec4(max.x, min.y, uv.z, uv.w), color, page };
+		Vertex topRight = { glm::vec4(max.x, max.y, uv.z, uv.y), color, page };
+		vertices.push_back(topLeft);
+		vertices.push_back(bottomLeft);
+		vertices.push_back(bottomRight);
+		vertices.push_back(topLeft);
+		vertices.push_back(bottomRight);
+		vertices.push_back(topRight);
+	}
+};
+
+#endif
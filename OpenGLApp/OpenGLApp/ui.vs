@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout (location = 1) in vec4 aColor;
+layout (location = 2) in float page;  // layer of the font atlas
+out vec3 TexCoords;
+out vec4 Color;
+
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    TexCoords = vec3(vertex.zw, page);
+    Color = aColor;
+}
\ No newline at end of file
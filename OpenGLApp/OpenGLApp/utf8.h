@@ -0,0 +1,56 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstdint>
+#include <string>
+
+const uint32_t ReplacementCharacter = 0xFFFD;
+
+// Decodes the code point starting at text[i] and moves i past it.
+// Malformed or truncated sequences give U+FFFD and skip one byte, so decoding
+// always makes progress and never reads past the end
+inline uint32_t NextCodepoint(const std::string& text, size_t& i) {
+	unsigned char lead = static_cast<unsigned char>(text[i++]);
+	if (lead < 0x80) {
+		return lead;
+	}
+
+	int extra;
+	uint32_t codepoint;
+	uint32_t minimum;
+	if ((lead & 0xE0) == 0xC0) {
+		extra = 1;
+		codepoint = lead & 0x1F;
+		minimum = 0x80;
+	}
+	else if ((lead & 0xF0) == 0xE0) {
+		extra = 2;
+		codepoint = lead & 0x0F;
+		minimum = 0x800;
+	}
+	else if ((lead & 0xF8) == 0xF0) {
+		extra = 3;
+		codepoint = lead & 0x07;
+		minimum = 0x10000;
+	}
+	else {
+		return ReplacementCharacter;
+	}
+
+	size_t start = i;
+	for (int k = 0; k < extra; k++) {
+		if (i >= text.size() || (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80) {
+			i = start;
+			return ReplacementCharacter;
+		}
+		codepoint = (codepoint << 6) | (static_cast<unsigned char>(text[i++]) & 0x3F);
+	}
+	// Overlong forms, UTF-16 surrogates and values past U+10FFFF are not valid UTF-8
+	if (codepoint < minimum || (codepoint >= 0xD800 && codepoint <= 0xDFFF) || codepoint > 0x10FFFF) {
+		i = start;
+		return ReplacementCharacter;
+	}
+	return codepoint;
+}
+
+#endif